@@ -0,0 +1,176 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description: 无锁MPMC环形队列和加锁队列的竞争测试
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 18:02:37
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 18:02:37
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "../headers/mpmcqueue.h"
+
+/*
+ * 相同数量的生产者和消费者线程通过一个有界队列传递整数，队列操作之外几乎不做其他事情，
+ * 耗时主要在下标/锁的竞争和线程的休眠唤醒上，比较MpmcQueue和std::mutex+std::queue实现的有界阻塞队列
+ * 从开始生产到所有元素被消费完计时，输出每秒传递的元素数（百万）
+ * 用法：MpmcBench [元素总数] [队列容量]，默认1000000个元素、容量1024
+ */
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int THREADS[] = {1, 2, 4, 8, 16, 32, 64}; // 生产者数（消费者数相同）
+static const int REPEAT = 3;                           // 重复次数，取最好的一次
+
+/*
+ * 加锁的有界阻塞队列，接口同MpmcQueue的push/pop/close，作为对照
+ */
+template <class T>
+class MutexQueue
+{
+public:
+    explicit MutexQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+    bool push(const T &item)
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        notFull_.wait(locker, [this]
+                      { return closed_ || queue_.size() < capacity_; });
+        if (closed_)
+        {
+            return false;
+        }
+        queue_.push(item);
+        locker.unlock();
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        notEmpty_.wait(locker, [this]
+                       { return closed_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            return false;
+        }
+        item = queue_.front();
+        queue_.pop();
+        locker.unlock();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    size_t capacity_;                  // 容量
+    bool closed_;                      // 是否已关闭
+    std::queue<T> queue_;              // 队列
+    std::mutex mtx_;                   // 互斥锁
+    std::condition_variable notEmpty_; // 消费者等待队列非空
+    std::condition_variable notFull_;  // 生产者等待队列不满
+};
+
+/*
+ * 测试一种队列，threads个生产者和threads个消费者，共传递total个元素，返回每秒传递的元素数（百万）
+ */
+template <class Q>
+static double bench(int threads, long total, size_t capacity)
+{
+    Q queue(capacity);
+    std::atomic<long> consumed(0);
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    BenchClock::time_point start = BenchClock::now();
+    for (int c = 0; c < threads; c++)
+    {
+        consumers.emplace_back([&queue, &consumed]
+                               {
+                                   long item;
+                                   long count = 0;
+                                   while (queue.pop(item))
+                                   {
+                                       count++;
+                                   }
+                                   consumed.fetch_add(count, std::memory_order_relaxed);
+                               });
+    }
+    for (int p = 0; p < threads; p++)
+    {
+        // 元素平均分给各个生产者，余数给第一个
+        long count = total / threads + (p == 0 ? total % threads : 0);
+        producers.emplace_back([&queue, count]
+                               {
+                                   for (long i = 0; i < count; i++)
+                                   {
+                                       queue.push(i);
+                                   }
+                               });
+    }
+    for (std::thread &t : producers)
+    {
+        t.join();
+    }
+    // 生产者都结束后关闭队列，消费者取完剩余元素后退出
+    queue.close();
+    for (std::thread &t : consumers)
+    {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    if (consumed.load() != total)
+    {
+        fprintf(stderr, "%ld of %ld items consumed\n", consumed.load(), total);
+        exit(1);
+    }
+    return total / seconds / 1e6;
+}
+
+/*
+ * 重复测试一种队列，返回最好的一次
+ */
+template <class Q>
+static double best(int threads, long total, size_t capacity)
+{
+    double result = 0;
+    for (int i = 0; i < REPEAT; i++)
+    {
+        result = std::max(result, bench<Q>(threads, total, capacity));
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    long total = argc > 1 ? atol(argv[1]) : 1000000;
+    size_t capacity = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1024;
+    printf("%u cpus, %ld items, capacity %zu (Mitems/s)\n", std::thread::hardware_concurrency(), total, capacity);
+    printf("%-12s %10s %10s\n", "prod/cons", "MpmcQueue", "mutex");
+    for (int threads : THREADS)
+    {
+        double lockfree = best<MpmcQueue<long>>(threads, total, capacity);
+        double locked = best<MutexQueue<long>>(threads, total, capacity);
+        printf("%5d/%-6d %10.2f %10.2f\n", threads, threads, lockfree, locked);
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description: 手写请求头解析器和原来的正则解析器的性能对比
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 18:26:53
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 18:26:53
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+#include <regex>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../headers/buffer.h"
+#include "../headers/httprequest.h"
+
+/*
+ * 单线程反复解析同一个浏览器风格的GET请求（请求首行加9个请求头，约460字节），
+ * 每次都把请求写入缓冲区再解析完，相当于一个长连接上连续到来的请求
+ * 按线程CPU时间计时，输出每个核每秒解析的请求数，同时统计每个请求的堆分配次数
+ * 手写解析器通过HttpRequest::parse测试（parseHeaders_和parseRequestLine_），
+ * 正则解析器是替换前HttpRequest中解析请求首行和请求头的代码，只保留在这里作为对照
+ * 用法：ParserBench [请求数]，默认200000
+ */
+
+static const char REQUEST[] =
+    "GET /picture HTTP/1.1\r\n"
+    "Host: 192.168.1.100:1316\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/114.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Referer: http://192.168.1.100:1316/index.html\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "\r\n";
+
+static const int REPEAT = 3; // 重复次数，取最好的一次
+
+static unsigned long allocs; // 堆分配次数
+
+// note: 替换全局的operator new以统计堆分配次数，std::string、std::regex等的分配都会经过这里
+void *operator new(size_t size)
+{
+    allocs++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+/*
+ * 替换前的正则解析器，只包含请求首行和请求头（GET请求到空行即解析完成）
+ */
+class RegexParser
+{
+public:
+    RegexParser() : state_(HttpRequest::REQUEST_LINE) {}
+
+    void init()
+    {
+        method_ = path_ = version_ = "";
+        state_ = HttpRequest::REQUEST_LINE;
+        header_.clear();
+    }
+
+    HttpRequest::HTTP_CODE parse(Buffer &buff)
+    {
+        const char CRLF[] = "\r\n";
+        if (buff.readableBytes() <= 0)
+        {
+            return HttpRequest::NO_REQUEST;
+        }
+        while (buff.readableBytes() && state_ != HttpRequest::FINISH)
+        {
+            const char *rdp = buff.peek();
+            const char *wdp = buff.beginWriteConst();
+            const char *lineEnd = std::search(rdp, wdp, CRLF, CRLF + 2);
+            std::string line(rdp, lineEnd);
+            if (lineEnd == wdp && state_ == HttpRequest::HEADER)
+            {
+                break;
+            }
+            switch (state_)
+            {
+            case HttpRequest::REQUEST_LINE:
+                if (!parseRequestLine_(line))
+                {
+                    return HttpRequest::BAD_REQUEST;
+                }
+                parsePath_();
+                break;
+            case HttpRequest::HEADER:
+                parseHeader_(line);
+                if (state_ == HttpRequest::BODY && method_ == "GET")
+                {
+                    state_ = HttpRequest::FINISH;
+                    buff.retrieveAll();
+                    return HttpRequest::GET_REQUEST;
+                }
+                break;
+            default:
+                // 对照组只解析GET请求
+                return HttpRequest::INTERNAL_ERROR;
+            }
+            buff.retrieveUntil(lineEnd + 2);
+        }
+        return HttpRequest::NO_REQUEST;
+    }
+
+private:
+    bool parseRequestLine_(const std::string &line)
+    {
+        std::regex pattern("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
+        std::smatch subMatch;
+        if (std::regex_match(line, subMatch, pattern))
+        {
+            method_ = subMatch[1];
+            path_ = subMatch[2];
+            version_ = subMatch[3];
+            state_ = HttpRequest::HEADER;
+            return true;
+        }
+        return false;
+    }
+
+    void parseHeader_(const std::string &line)
+    {
+        std::regex pattern("^([^:]*): ?(.*)$");
+        std::smatch subMatch;
+        if (std::regex_match(line, subMatch, pattern))
+        {
+            header_[subMatch[1]] = subMatch[2];
+        }
+        else
+        {
+            state_ = HttpRequest::BODY;
+        }
+    }
+
+    void parsePath_()
+    {
+        static const std::unordered_set<std::string> DEFAULT_HTML{
+            "/index", "/register", "/login", "/welcome", "/video", "/picture", "/upload", "/success"};
+        if (path_ == "/")
+        {
+            path_ = "/index.html";
+        }
+        else if (DEFAULT_HTML.count(path_))
+        {
+            path_ += ".html";
+        }
+    }
+
+    HttpRequest::PARSE_STATE state_;
+    std::string method_, path_, version_;
+    std::unordered_map<std::string, std::string> header_;
+};
+
+// 当前线程的CPU时间（秒）
+static double cpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * 测试一种解析器，n为请求数，返回每个核每秒解析的请求数，perReq返回每个请求的堆分配次数
+ */
+template <class P>
+static double bench(int n, double &perReq)
+{
+    P parser;
+    Buffer buff;
+    // 预热，让缓冲区和解析器复用的内存先分配好
+    buff.append(REQUEST, sizeof(REQUEST) - 1);
+    parser.parse(buff);
+    unsigned long startAllocs = allocs;
+    double start = cpuSeconds();
+    for (int i = 0; i < n; i++)
+    {
+        parser.init();
+        buff.append(REQUEST, sizeof(REQUEST) - 1);
+        if (parser.parse(buff) != HttpRequest::GET_REQUEST)
+        {
+            fprintf(stderr, "parse failed\n");
+            exit(1);
+        }
+    }
+    double seconds = cpuSeconds() - start;
+    perReq = static_cast<double>(allocs - startAllocs) / n;
+    return n / seconds;
+}
+
+/*
+ * 重复测试一种解析器，输出最好的一次，name为输出的名称
+ */
+template <class P>
+static void report(const char *name, int n)
+{
+    double best = 0;
+    double perReq = 0;
+    for (int i = 0; i < REPEAT; i++)
+    {
+        best = std::max(best, bench<P>(n, perReq));
+    }
+    printf("%-14s %14.0f %14.1f\n", name, best, perReq);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 200000;
+    printf("%d requests of %zu bytes\n", n, sizeof(REQUEST) - 1);
+    printf("%-14s %14s %14s\n", "parser", "req/s/core", "allocs/req");
+    // 正则解析器慢三个数量级，减少请求数
+    report<RegexParser>("regex", std::max(n / 100, 1));
+    report<HttpRequest>("hand-written", n);
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description: 线程池各调度模式的竞争测试
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 17:34:12
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 17:34:12
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "../headers/threadpool.h"
+
+/*
+ * 多个生产者线程（相当于Reactor）同时向线程池提交大量很短的任务，任务本身几乎不花时间，
+ * 耗时主要在任务队列的锁竞争和线程的唤醒上，比较SHARED（原来的单队列线程池）和其他调度模式的吞吐量
+ * 从开始提交到所有任务执行完计时，输出每秒完成的任务数（百万）
+ * note: 无锁队列模式的环形队列有容量上限，使用CALLER_RUNS策略，队列满时由生产者执行，所有任务都会完成
+ * 用法：PoolBench [工作线程数] [每个生产者的任务数]，默认8个工作线程、每个生产者200000个任务
+ */
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int PRODUCERS[] = {1, 2, 4}; // 生产者线程数
+static const int WORK = 64;               // 每个任务的计算量（循环次数）
+static const int REPEAT = 3;              // 重复次数，取最好的一次
+
+static const char *const MODE_NAMES[] = {"SHARED", "STEALING", "AFFINITY", "LOCKFREE"}; // 按ThreadPool::MODE的顺序
+
+/*
+ * 测试一种模式，返回每秒完成的任务数（百万）
+ */
+static double bench(ThreadPool::MODE mode, int threads, int producers, int tasks)
+{
+    std::atomic<long> done(0);
+    long total = static_cast<long>(producers) * tasks;
+    BenchClock::time_point start;
+    {
+        ThreadPool pool(threads, mode, 0, ThreadPool::CALLER_RUNS);
+        std::vector<std::thread> workers;
+        start = BenchClock::now();
+        for (int p = 0; p < producers; p++)
+        {
+            workers.emplace_back([&pool, &done, p, tasks]
+                                 {
+                                     for (int i = 0; i < tasks; i++)
+                                     {
+                                         // 亲和模式下按键分配，模拟按fd分配
+                                         pool.addTask([&done]
+                                                      {
+                                                          volatile int x = 0;
+                                                          for (int k = 0; k < WORK; k++)
+                                                          {
+                                                              x += k;
+                                                          }
+                                                          done.fetch_add(1, std::memory_order_relaxed);
+                                                      },
+                                                      [] {}, static_cast<size_t>(p * tasks + i));
+                                     }
+                                 });
+        }
+        for (std::thread &t : workers)
+        {
+            t.join();
+        }
+        while (done.load(std::memory_order_relaxed) < total)
+        {
+            std::this_thread::yield();
+        }
+    }
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    return total / seconds / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 8;
+    int tasks = argc > 2 ? atoi(argv[2]) : 200000;
+    printf("%u cpus, %d workers, %d tasks per producer (Mtasks/s)\n", std::thread::hardware_concurrency(), threads, tasks);
+    printf("%-10s", "mode");
+    for (int producers : PRODUCERS)
+    {
+        printf(" %8d prod", producers);
+    }
+    printf("\n");
+    for (size_t mode = 0; mode < sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]); mode++)
+    {
+        printf("%-10s", MODE_NAMES[mode]);
+        for (int producers : PRODUCERS)
+        {
+            double best = 0;
+            for (int i = 0; i < REPEAT; i++)
+            {
+                best = std::max(best, bench(static_cast<ThreadPool::MODE>(mode), threads, producers, tasks));
+            }
+            printf(" %13.2f", best);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description: HeapTimer和TimeWheel的性能对比
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 17:20:41
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 17:20:41
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include "../headers/heaptimer.h"
+#include "../headers/timewheel.h"
+
+/*
+ * 模拟服务器中定时器的用法，以fd为id，每种操作分别计时，输出每次操作的平均耗时（ns）
+ * add：添加n个定时器，超时时间在[30s, 60s)之间随机（已经空闲了不同时间的长连接）
+ * adjust：随机选择连接把超时时间刷新为60s，每次读写事件都会调用一次，是最频繁的操作
+ * note: 和服务器一样adjust只会推迟超时时间，HeapTimer::adjust只下移调整堆
+ * cancel：连接关闭时删除定时器
+ * expire：n个定时器在100ms内陆续到期，等全部到期后一次tick触发所有回调
+ * 每项重复REPEAT次取最小值，减少其他进程和缺页的干扰
+ * 用法：TimerBench [定时器数量...]，默认10000和100000
+ */
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int TIMEOUT_MS = 60000;  // 连接的空闲超时
+static const int ADJUST_ROUNDS = 10;  // adjust的次数为定时器数量的倍数
+static const int REPEAT = 3;          // 重复次数
+
+// 一次测试的结果，每种操作的平均耗时（ns）
+struct Result
+{
+    double add;
+    double adjust;
+    double cancel;
+    double expire;
+};
+
+static volatile long fired; // 到期回调的触发次数
+
+// 从start到现在每次操作的平均耗时（ns）
+static double nsPerOp(BenchClock::time_point start, size_t ops)
+{
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / ops;
+}
+
+/*
+ * 测试一种定时器，n为定时器数量
+ */
+template <class T>
+static Result bench(int n)
+{
+    Result result;
+    std::mt19937 rng(n);
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    // add
+    std::unique_ptr<Timer> timer(new T);
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < n; i++)
+    {
+        timer->add(i, 30000 + rng() % 30000, []
+                   { fired++; });
+    }
+    result.add = nsPerOp(start, n);
+
+    // adjust
+    size_t rounds = static_cast<size_t>(n) * ADJUST_ROUNDS;
+    std::vector<int> ids(rounds);
+    for (size_t i = 0; i < rounds; i++)
+    {
+        ids[i] = rng() % n;
+    }
+    start = BenchClock::now();
+    for (size_t i = 0; i < rounds; i++)
+    {
+        timer->adjust(ids[i], TIMEOUT_MS);
+    }
+    result.adjust = nsPerOp(start, rounds);
+
+    // cancel，按随机顺序删除
+    start = BenchClock::now();
+    for (int i = 0; i < n; i++)
+    {
+        timer->cancel(order[i]);
+    }
+    result.cancel = nsPerOp(start, n);
+
+    // expire
+    timer.reset(new T);
+    for (int i = 0; i < n; i++)
+    {
+        timer->add(i, rng() % 100, []
+                   { fired++; });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    fired = 0;
+    start = BenchClock::now();
+    timer->tick();
+    result.expire = nsPerOp(start, n);
+    if (fired != n)
+    {
+        fprintf(stderr, "%ld of %d timers fired\n", fired, n);
+        exit(1);
+    }
+    return result;
+}
+
+/*
+ * 重复测试一种定时器，输出每种操作的最小耗时，name为输出的名称
+ */
+template <class T>
+static void report(const char *name, int n)
+{
+    Result best = bench<T>(n);
+    for (int i = 1; i < REPEAT; i++)
+    {
+        Result result = bench<T>(n);
+        best.add = std::min(best.add, result.add);
+        best.adjust = std::min(best.adjust, result.adjust);
+        best.cancel = std::min(best.cancel, result.cancel);
+        best.expire = std::min(best.expire, result.expire);
+    }
+    printf("%-10s %8d %10.1f %10.1f %10.1f %10.1f\n", name, n, best.add, best.adjust, best.cancel, best.expire);
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        sizes.push_back(atoi(argv[i]));
+    }
+    if (sizes.empty())
+    {
+        sizes = {10000, 100000};
+    }
+    printf("%-10s %8s %10s %10s %10s %10s   (ns/op)\n", "timer", "timers", "add", "adjust", "cancel", "expire");
+    for (int n : sizes)
+    {
+        report<HeapTimer>("HeapTimer", n);
+        report<TimeWheel>("TimeWheel", n);
+    }
+    return 0;
+}
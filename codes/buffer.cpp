@@ -58,6 +58,14 @@ const char *Buffer::peek() const
     return beginPtr_() + readPos_;
 }
 
+/*
+ * 返回当前readPos_所在字符地址的指针，调用者可以原地修改可读数据
+ */
+char *Buffer::beginRead()
+{
+    return beginPtr_() + readPos_;
+}
+
 /*
  * 移动readPos_指针，表示这一段已经被读取了
  */
@@ -98,6 +106,24 @@ std::string Buffer::retrieveAllToStr()
     return str;
 }
 
+/*
+ * 在可读数据中查找CRLF，返回\r的位置，没有找到时返回nullptr
+ */
+const char *Buffer::findCRLF() const
+{
+    return findCRLF(peek());
+}
+
+/*
+ * 从start开始在可读数据中查找CRLF，按CPU支持的指令集使用SIMD扫描（见simdscan.h）
+ */
+const char *Buffer::findCRLF(const char *start) const
+{
+    assert(peek() <= start && start <= beginWriteConst());
+    const char *crlf = SimdScan::findCRLF(start, beginWriteConst());
+    return crlf == beginWriteConst() ? nullptr : crlf;
+}
+
 /*
  * 计算缓冲区中能够开始写数据的位置
  */
@@ -123,6 +149,15 @@ void Buffer::hasWritten(size_t len)
     writePos_ += len;
 }
 
+/*
+ * 撤销最后写入的len个字节，可读数据变短
+ */
+void Buffer::unwrite(size_t len)
+{
+    assert(len <= readableBytes());
+    writePos_ -= len;
+}
+
 /*
  * 使用标准库的std函数将指定大小数据复制到BeginWrite()指定的缓冲区中
  */
@@ -0,0 +1,240 @@
+#include "../headers/chunked.h"
+
+/*
+ * 构造函数
+ */
+ChunkedDecoder::ChunkedDecoder()
+{
+    init();
+}
+
+/*
+ * 开始解码一个请求体
+ */
+void ChunkedDecoder::init()
+{
+    state_ = SIZE;
+    left_ = 0;
+    decoded_ = 0;
+    total_ = 0;
+    trailer_.clear();
+}
+
+/*
+ * buff开头已经解码、调用者还没有处理的数据长度
+ */
+size_t ChunkedDecoder::decoded() const
+{
+    return decoded_;
+}
+
+/*
+ * 调用者处理并回收了buff开头len字节解码后的数据
+ */
+void ChunkedDecoder::consume(size_t len)
+{
+    decoded_ -= len;
+}
+
+/*
+ * 是否已经读到最后一个分块和尾部字段的结尾
+ */
+bool ChunkedDecoder::finished() const
+{
+    return state_ == DONE;
+}
+
+/*
+ * 已经解码的请求体总长度
+ */
+size_t ChunkedDecoder::total() const
+{
+    return total_;
+}
+
+/*
+ * 尾部字段
+ */
+const std::string &ChunkedDecoder::trailer() const
+{
+    return trailer_;
+}
+
+/*
+ * 解码buff中新到达的数据
+ * buff中的数据依次是：调用者还没有处理的解码后的数据（decoded_字节）、还没有解码的数据
+ * 解码时分块数据前移，覆盖掉已经解析过的分块大小行和CRLF，最后把剩下的数据也前移，缓冲区变短
+ * 每个字节最多移动一次；缓冲区开头没有解码后的数据时，分块格式直接回收，分块数据不需要移动
+ */
+bool ChunkedDecoder::decode(Buffer &buff)
+{
+    char *begin = buff.beginRead();
+    char *end = begin + buff.readableBytes();
+    // [begin, dst)是解码后的数据，[dst, p)是已经解析过的分块格式，[p, end)还没有解码
+    char *dst = begin + decoded_;
+    char *p = dst;
+    bool more = true;
+    while (more && p < end)
+    {
+        switch (state_)
+        {
+        case SIZE:
+        {
+            const char *lineEnd = SimdScan::findCRLF(p, end);
+            if (lineEnd == end)
+            {
+                if (static_cast<size_t>(end - p) > MAX_SIZE_LINE)
+                {
+                    fail_("Chunk Size Line Too Long");
+                }
+                more = false;
+                break;
+            }
+            if (!parseSize_(p, lineEnd))
+            {
+                more = false;
+                break;
+            }
+            p += lineEnd + 2 - p;
+            // 大小为0的分块是最后一个分块，之后是尾部字段
+            state_ = left_ > 0 ? DATA : TRAILER;
+            break;
+        }
+        case DATA:
+        {
+            if (dst == begin && p != dst)
+            {
+                buff.retrieve(p - begin);
+                begin = dst = p;
+            }
+            size_t n = std::min(left_, static_cast<size_t>(end - p));
+            if (dst != p)
+            {
+                memmove(dst, p, n);
+            }
+            dst += n;
+            p += n;
+            left_ -= n;
+            total_ += n;
+            if (left_ == 0)
+            {
+                state_ = DATA_CRLF;
+            }
+            break;
+        }
+        case DATA_CRLF:
+            if (end - p < 2)
+            {
+                more = false;
+                break;
+            }
+            if (p[0] != '\r' || p[1] != '\n')
+            {
+                fail_("Missing Chunk CRLF");
+                more = false;
+                break;
+            }
+            p += 2;
+            state_ = SIZE;
+            break;
+        case TRAILER:
+        {
+            const char *lineEnd = SimdScan::findCRLF(p, end);
+            size_t len = lineEnd == end ? end - p : lineEnd + 2 - p;
+            if (trailer_.size() + len > MAX_TRAILER)
+            {
+                fail_("Trailer Too Large");
+                more = false;
+                break;
+            }
+            if (lineEnd == end)
+            {
+                more = false;
+                break;
+            }
+            // 空行，请求体结束，之后的数据属于流水线上的下一个请求
+            if (lineEnd == p)
+            {
+                p += 2;
+                state_ = DONE;
+                more = false;
+                break;
+            }
+            trailer_.append(p, len);
+            p += len;
+            break;
+        }
+        // 解码完成或者格式错误之后不再处理
+        default:
+            more = false;
+            break;
+        }
+    }
+    // 去掉已经解析过的分块格式
+    if (dst == begin)
+    {
+        buff.retrieve(p - begin);
+    }
+    else if (p != dst)
+    {
+        memmove(dst, p, end - p);
+        buff.unwrite(p - dst);
+    }
+    decoded_ = dst - begin;
+    return state_ != FAILED;
+}
+
+/*
+ * 解析分块大小行：1*HEXDIG [ BWS ";" 分块扩展 ]，分块扩展忽略
+ */
+bool ChunkedDecoder::parseSize_(const char *begin, const char *end)
+{
+    const char *p = begin;
+    left_ = 0;
+    for (; p < end; p++)
+    {
+        int digit;
+        if (*p >= '0' && *p <= '9')
+        {
+            digit = *p - '0';
+        }
+        else if ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'f')
+        {
+            digit = (*p | 0x20) - 'a' + 10;
+        }
+        else
+        {
+            break;
+        }
+        if (left_ > (SIZE_MAX >> 4))
+        {
+            fail_("Chunk Size Overflow");
+            return false;
+        }
+        left_ = left_ << 4 | digit;
+    }
+    if (p == begin)
+    {
+        fail_("Bad Chunk Size");
+        return false;
+    }
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    if (p != end && *p != ';')
+    {
+        fail_("Bad Chunk Size");
+        return false;
+    }
+    return true;
+}
+
+/*
+ * 格式错误，之后的数据不再处理
+ */
+void ChunkedDecoder::fail_(const char *reason)
+{
+    LOG_ERROR("Chunked Error! %s", reason);
+    state_ = FAILED;
+}
@@ -38,13 +38,44 @@ Config::Config()
     actor = 0;
     // 守护进程，默认不开启
     is_daemon = false;
+    // 事件循环模式：单Reactor(0)/多Reactor+SO_REUSEPORT(1)/主从Reactor(2)，默认单Reactor
+    reactorMode = 0;
+    // Reactor数量，默认与CPU核数相同（单Reactor模式无效）
+    reactorNum = 0;
+    // 主从Reactor模式下新连接分配策略，默认轮询
+    balance = 0;
+    // 事件后端：epoll(0)/io_uring(1)/io_uring+SQPOLL(2)，默认epoll，io_uring不可用时自动回退到epoll
+    ioBackend = 0;
+    // 监听队列长度，默认读取/proc/sys/net/core/somaxconn
+    backlog = 0;
+    // 每次监听事件最多accept的连接数，默认64，避免连接风暴时accept长时间占用事件循环
+    acceptBatch = 64;
+    // 定时器：小根堆(0)/分层时间轮(1)，默认小根堆
+    timerType = 0;
+    // 惰性定时器，默认关闭
+    lazyTimer = false;
+    // 线程池调度模式，默认共享队列
+    poolMode = 0;
+    // 线程池任务队列的最大长度，默认不限制
+    maxTasks = 0;
+    // 任务队列已满时的拒绝策略，默认拒绝新任务（向客户端返回503）
+    rejectPolicy = 0;
+    // CoDel准入控制，默认关闭，开启时常用目标排队时间5ms、观察区间100ms
+    codelTarget = 0;
+    codelInterval = 100;
+    // 数据库线程池数量，默认2
+    dbThreadNum = 2;
+    // 工作线程绑定CPU，默认关闭
+    pinCpu = false;
+    // 线程池数量上限，默认固定线程数
+    maxThreadNum = 0;
 }
 
 // 处理命令行参数
 void Config::ParseCmd(int argc, char *argv[])
 {
     int opt;
-    const char *str = "p:l:m:o:s:t:e:a:d:";
+    const char *str = "p:l:m:o:s:t:e:a:d:r:n:b:u:k:c:w:z:q:j:g:x:y:i:f:v:";
     while ((opt = getopt(argc, argv, str)) != -1)
     {
         switch (opt)
@@ -76,6 +107,54 @@ void Config::ParseCmd(int argc, char *argv[])
         case 'd':
             is_daemon = atoi(optarg);
             break;
+        case 'r':
+            reactorMode = atoi(optarg);
+            break;
+        case 'n':
+            reactorNum = atoi(optarg);
+            break;
+        case 'b':
+            balance = atoi(optarg);
+            break;
+        case 'u':
+            ioBackend = atoi(optarg);
+            break;
+        case 'k':
+            backlog = atoi(optarg);
+            break;
+        case 'c':
+            acceptBatch = atoi(optarg);
+            break;
+        case 'w':
+            timerType = atoi(optarg);
+            break;
+        case 'z':
+            lazyTimer = atoi(optarg);
+            break;
+        case 'q':
+            poolMode = atoi(optarg);
+            break;
+        case 'j':
+            maxTasks = atoi(optarg);
+            break;
+        case 'g':
+            rejectPolicy = atoi(optarg);
+            break;
+        case 'x':
+            codelTarget = atoi(optarg);
+            break;
+        case 'y':
+            codelInterval = atoi(optarg);
+            break;
+        case 'i':
+            dbThreadNum = atoi(optarg);
+            break;
+        case 'f':
+            pinCpu = atoi(optarg);
+            break;
+        case 'v':
+            maxThreadNum = atoi(optarg);
+            break;
         default:
             break;
         }
@@ -2,11 +2,24 @@
 
 /*
  * 构造函数
- * 初始化列表中初始化epoll文件描述符与最大监听数量
+ * 初始化列表中初始化最大监听数量，根据后端创建io_uring实例或epoll文件描述符
+ * 内核不支持io_uring时回退到epoll
  */
-Epoller::Epoller(int maxEvent) : epollFd_(epoll_create(512)), events_(maxEvent)
+Epoller::Epoller(int maxEvent, BACKEND backend) : epollFd_(-1), events_(maxEvent)
 {
-    assert(epollFd_ >= 0 && events_.size() > 0);
+    if (backend == URING || backend == URING_SQPOLL)
+    {
+        uring_.reset(new UringPoller(4096, backend == URING_SQPOLL));
+        if (!uring_->isOpen())
+        {
+            uring_.reset();
+        }
+    }
+    if (!uring_)
+    {
+        epollFd_ = epoll_create(512);
+    }
+    assert((uring_ || epollFd_ >= 0) && events_.size() > 0);
 }
 
 /*
@@ -14,7 +27,22 @@ Epoller::Epoller(int maxEvent) : epollFd_(epoll_create(512)), events_(maxEvent)
  */
 Epoller::~Epoller()
 {
-    close(epollFd_);
+    if (epollFd_ >= 0)
+    {
+        close(epollFd_);
+    }
+}
+
+/*
+ * 返回实际使用的事件后端
+ */
+Epoller::BACKEND Epoller::backend() const
+{
+    if (!uring_)
+    {
+        return EPOLL;
+    }
+    return uring_->isSqpoll() ? URING_SQPOLL : URING;
 }
 
 /*
@@ -26,6 +54,10 @@ bool Epoller::addFd(int fd, uint32_t events)
     {
         return false;
     }
+    if (uring_)
+    {
+        return uring_->addFd(fd, events);
+    }
     epoll_event ev = {0};
     ev.data.fd = fd;
     ev.events = events;
@@ -43,6 +75,11 @@ bool Epoller::modFd(int fd, uint32_t events)
     {
         return false;
     }
+    // io_uring后端只是写入提交队列，不需要系统调用
+    if (uring_)
+    {
+        return uring_->modFd(fd, events);
+    }
     epoll_event ev = {0};
     ev.data.fd = fd;
     ev.events = events;
@@ -59,6 +96,10 @@ bool Epoller::delFd(int fd)
     {
         return false;
     }
+    if (uring_)
+    {
+        return uring_->delFd(fd);
+    }
     epoll_event ev = {0};
 
     return 0 == epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &ev);
@@ -69,6 +110,10 @@ bool Epoller::delFd(int fd)
  */
 int Epoller::wait(int timeoutMS)
 {
+    if (uring_)
+    {
+        return uring_->wait(&events_[0], static_cast<int>(events_.size()), timeoutMS);
+    }
     // 因为events_是vector，所以应该取events_[0]数据所在的地址才对
     return epoll_wait(epollFd_, &events_[0], static_cast<int>(events_.size()), timeoutMS);
 }
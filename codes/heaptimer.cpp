@@ -22,9 +22,10 @@ HeapTimer::~HeapTimer()
 void HeapTimer::shiftup_(size_t i)
 {
     assert(i >= 0 && i < heap_.size());
-    size_t j = (i - 1) / 2; // 父节点
-    while (j >= 0)
+    // 注意：size_t为无符号数，i为0时(i - 1) / 2会溢出，所以用i > 0判断是否还有父节点
+    while (i > 0)
     {
+        size_t j = (i - 1) / 2; // 父节点
         // 不需要上移了
         if (heap_[j] < heap_[i])
         {
@@ -34,8 +35,6 @@ void HeapTimer::shiftup_(size_t i)
         swapNode_(i, j);
         // 更新当前节点
         i = j;
-        // 更新父节点
-        j = (i - 1) / 2;
     }
 }
 
@@ -128,10 +127,22 @@ void HeapTimer::doWork(int id)
     // 获取TimerNode
     size_t i = ref_[id];
     TimerNode node = heap_[i];
-    // 执行回调函数
-    node.cb();
-    // 删除TimerNode
+    // 先删除TimerNode再执行回调函数，回调函数中可能重新添加同一个id的定时器
     del_(i);
+    node.cb();
+}
+
+/*
+ * 删除指定id结点，不触发回调函数（连接关闭时调用，fd可能被其他Reactor复用）
+ */
+void HeapTimer::cancel(int id)
+{
+    auto it = ref_.find(id);
+    if (it == ref_.end())
+    {
+        return;
+    }
+    del_(it->second);
 }
 
 /*
@@ -164,11 +175,16 @@ void HeapTimer::del_(size_t index)
  */
 void HeapTimer::adjust(int id, int timeout)
 {
-    assert(!heap_.empty() && ref_.count(id) > 0);
+    // 定时器可能已经触发（单所有者模式下连接正在等待所有者关闭），此时忽略
+    auto it = ref_.find(id);
+    if (it == ref_.end())
+    {
+        return;
+    }
     // 调整指定id的结点
-    heap_[ref_[id]].expires = Clock::now() + MS(timeout);
+    heap_[it->second].expires = Clock::now() + MS(timeout);
     // 时间增大，下移调整堆
-    shiftdown_(ref_[id], heap_.size());
+    shiftdown_(it->second, heap_.size());
 }
 
 /*
@@ -180,19 +196,21 @@ void HeapTimer::tick()
     {
         return;
     }
+    // 只取一次当前时间
+    TimeStamp now = Clock::now();
     // while遍历
     while (!heap_.empty())
     {
         TimerNode node = heap_.front();
         // 当前时间<节点超时时间，小根堆，后面的节点超时时间更大，都没有超时，直接break
-        if (std::chrono::duration_cast<MS>(node.expires - Clock::now()).count() > 0)
+        if (std::chrono::duration_cast<MS>(node.expires - now).count() > 0)
         {
             break;
         }
+        // 先移除超时节点，回调函数中可能重新添加同一个id的定时器（惰性定时器重新调度）
+        pop();
         // 当前时间>=节点超时时间，超时，触发回调函数
         node.cb();
-        // 移除超时节点
-        pop();
     }
 }
 
@@ -9,7 +9,7 @@ bool HttpConn::isET;                  // 工作模式
 /*
  * 构造函数中赋初值
  */
-HttpConn::HttpConn() : fd_(-1), isClose_(true)
+HttpConn::HttpConn() : fd_(-1), isClose_(true), readPaused_(false), events_(0), responseHead_(0), responseCnt_(0), toWrite_(0), isKeepAlive_(false)
 {
     addr_ = {0};
     // 初始化上传文件目录
@@ -38,6 +38,13 @@ void HttpConn::init(int sockfd, const sockaddr_in &addr)
     // 初始化读写缓冲区以及标志httpconn是否开启的变量
     writeBuff_.retrieveAll();
     readBuff_.retrieveAll();
+    responseHead_ = responseCnt_ = 0;
+    toWrite_ = 0;
+    isKeepAlive_ = false;
+    readPaused_ = false;
+    events_ = 0;
+    // 连接对象会被复用，清除上一个连接没有解析完的请求状态
+    request_.init();
     isClose_ = false;
     LOG_INFO("Client[%d](%s:%d) In, UserCount: %d", sockfd, getIP(), getPort(), (int)userCount);
 }
@@ -47,8 +54,14 @@ void HttpConn::init(int sockfd, const sockaddr_in &addr)
  */
 void HttpConn::close()
 {
-    // 解除内存映射
+    // 解除内存映射，包括还没发送完的响应
     response_.unmapFile();
+    while (responseCnt_ > 0)
+    {
+        popResponse_();
+    }
+    // 删除没有上传完的文件
+    request_.init();
     if (!isClose_)
     {
         isClose_ = true;
@@ -60,20 +73,72 @@ void HttpConn::close()
     }
 }
 
+/*
+ * 返回该连接是否已经关闭
+ */
+bool HttpConn::isClosed() const
+{
+    return isClose_;
+}
+
 /*
  * 返回还需要写多少字节的数据
  */
 int HttpConn::toWriteBytes()
 {
-    return iov_[0].iov_len + iov_[1].iov_len;
+    return toWrite_;
 }
 
 /*
- * 返回连接状态是否为长连接
+ * 返回连接状态是否为长连接，由最后一个入队的响应决定
  */
 bool HttpConn::isKeepAlive() const
 {
-    return request_.isKeepAlive();
+    return isKeepAlive_;
+}
+
+/*
+ * 记录最近一次活动的时间，代替每次读写事件都调整定时器
+ */
+void HttpConn::setLastActive(TimeStamp now)
+{
+    lastActive_ = now;
+}
+
+/*
+ * 返回最近一次活动的时间
+ */
+TimeStamp HttpConn::getLastActive() const
+{
+    return lastActive_;
+}
+
+/*
+ * 记录就绪事件并尝试获取所有权
+ * 返回true表示之前没有线程在处理该连接，调用者成为所有者，需要调度任务处理
+ * 返回false表示当前所有者会在释放所有权之前看到这些事件
+ */
+bool HttpConn::postEvents(uint32_t events)
+{
+    uint32_t prev = events_.fetch_or(events | OWNED, std::memory_order_acq_rel);
+    return !(prev & OWNED);
+}
+
+/*
+ * 所有者取出待处理的事件，保留所有权标志
+ */
+uint32_t HttpConn::takeEvents()
+{
+    return events_.exchange(OWNED, std::memory_order_acq_rel) & ~OWNED;
+}
+
+/*
+ * 所有者尝试释放所有权，只有在没有新事件到达时才能释放成功
+ */
+bool HttpConn::releaseOwner()
+{
+    uint32_t expected = OWNED;
+    return events_.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
 }
 
 /*
@@ -114,131 +179,273 @@ int HttpConn::getPort() const
 ssize_t HttpConn::read(int *saveErrno)
 {
     ssize_t len = -1;
+    size_t spliced = 0;
+    readPaused_ = false;
     // 如果是LT模式，那么只读取一次，如果是ET模式，会一直读取，直到读不出数据
     do
     {
-        len = readBuff_.readFd(fd_, saveErrno);
+        // 上传大文件时文件内容直接从socket splice到文件，不经过读缓冲区
+        if (request_.canSplice(readBuff_))
+        {
+            len = request_.splice(fd_, readBuff_, saveErrno);
+            spliced += len > 0 ? len : 0;
+        }
+        else
+        {
+            len = readBuff_.readFd(fd_, saveErrno);
+        }
         if (len <= 0)
         {
             break;
         }
+        // note: ET模式下读缓冲区达到上限时先停止读取，交给调用者解析消费后再继续读
+        // 否则上传大文件时对端发送得足够快，读缓冲区会随文件大小一直增长；splice的数据同样计数，一个连接不会一直占用工作线程
+        if (isET && readBuff_.readableBytes() + spliced >= MAX_READ_BUFFER)
+        {
+            readPaused_ = true;
+            break;
+        }
     } while (isET);
 
     return len;
 }
 
+/*
+ * 上一次read是否因为读缓冲区达到上限而停止
+ * EPOLLONESHOT模式下重新注册EPOLLIN时epoll会重新检查socket是否可读，不需要特殊处理；
+ * 单所有者模式下没有新的边沿，所有者需要在消费完读缓冲区后主动继续读
+ */
+bool HttpConn::readPaused() const
+{
+    return readPaused_;
+}
+
 /*
  * 使用writev方法将数据发送到指定socket中
  * writev函数用于在一次函数调用中写多个非连续缓冲区，有时也将这该函数称为聚集写
+ * 队列中所有响应的响应头和响应体按顺序组成iov_，一次writev发送，流水线请求的多个小响应不会各自占用一次系统调用
  */
 ssize_t HttpConn::write(int *saveErrno)
 {
     ssize_t len = -1;
     do
     {
+        // 响应头在writeBuff_中连续存放，缓冲区可能因为追加新的响应而搬移数据，所以每次都从peek()重新计算位置
+        char *head = const_cast<char *>(writeBuff_.peek());
+        int iovCnt = 0;
+        for (int i = 0; i < responseCnt_; i++)
+        {
+            Response &resp = responses_[(responseHead_ + i) % MAX_PIPELINE];
+            if (resp.headLen > 0)
+            {
+                iov_[iovCnt].iov_base = head;
+                iov_[iovCnt].iov_len = resp.headLen;
+                iovCnt++;
+                head += resp.headLen;
+            }
+            if (resp.fileLen > 0)
+            {
+                iov_[iovCnt].iov_base = resp.file;
+                iov_[iovCnt].iov_len = resp.fileLen;
+                iovCnt++;
+            }
+        }
         // note: 聚集写：写多个非连续缓冲区
-        len = writev(fd_, iov_, iovCnt_);
+        len = writev(fd_, iov_, iovCnt);
         if (len <= 0)
         {
             // 记录信号返回给调用函数
             *saveErrno = errno;
             break;
         }
-        // 两个传输位置长度都为0，表示传输结束
-        if (iov_[0].iov_len + iov_[1].iov_len == 0)
-        {
-            break;
-        }
-        // 如果发送的数据长度大于iov_[0].iov_len，说明第一块区域的数据是发送完毕
-        // 再根据多发送了多少调整iov_[1]的取值
-        else if (static_cast<size_t>(len) > iov_[0].iov_len)
+        toWrite_ -= len;
+        // 按顺序扣除已发送的长度：先是队头响应的响应头（回收writeBuff_的空间），再是响应体，发送完的响应出队
+        size_t remain = len;
+        while (remain > 0)
         {
-            iov_[1].iov_base = (uint8_t *)iov_[1].iov_base + (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            // 区域一的数据发送完毕，回收缓冲空间，并将长度归0
-            if (iov_[0].iov_len)
+            Response &resp = responses_[responseHead_];
+            size_t n = std::min(remain, resp.headLen);
+            writeBuff_.retrieve(n);
+            resp.headLen -= n;
+            remain -= n;
+            n = std::min(remain, resp.fileLen);
+            resp.file += n;
+            resp.fileLen -= n;
+            remain -= n;
+            if (resp.headLen == 0 && resp.fileLen == 0)
             {
-                writeBuff_.retrieveAll();
-                iov_[0].iov_len = 0;
+                popResponse_();
             }
         }
-        // 没有传输完区域一的内容那么就继续传区域一的
-        else
-        {
-            iov_[0].iov_base = (uint8_t *)iov_[0].iov_base + len;
-            iov_[0].iov_len -= len;
-            // 回收对应长度的空间
-            writeBuff_.retrieve(len);
-        }
-        // 仍需发送的数据大于10240的情况下会继续发送 或 若在LT模式下，只会发送一次，ET模式下会一直发送，直到完毕
-        // 这里有点问题，如果是LT模式，且需要写的数据小于等于10240，那么连接会被直接关闭，这里可以选择在调用函数处修改判断条件
-        // 或者直接将这里改为ToWriteBytes()>0
+        // 若在LT模式下，只会发送一次，ET模式下会一直发送，直到完毕
     } while (toWriteBytes() > 0);
     return len;
 }
 
 /*
  * 解析http请求数据
- * 本函数实际上时有bug的，不具备处理非完整请求的能力
- * 因为request_.parse(readBuff_)返回false可能是因为请求不完整，需要继续读取http请求数据
- * 但在此函数中却直接返回了400
- * 修改方案：request_.parse()修改为返回解析状态，然后本函数根据解析状态返回true or false
+ * 支持HTTP/1.1流水线：客户端可以不等响应连续发送多个请求，它们可能在同一次read中到达
+ * request_.parse每次只消费一个请求的数据，这里循环解析读缓冲区中所有完整的请求，按顺序生成响应排队
+ * 以下情况停止解析：请求不完整、需要访问数据库验证（验证完成并生成响应后再继续）、
+ * 上一个响应要关闭连接、解析出错（返回400并关闭连接）、队列已满（发送出去一部分后再继续）
+ * 返回是否有待发送的响应
  */
 bool HttpConn::process()
 {
-    // 首先初始化一个httprequest类对象，负责处理请求的事务
-    // 这里不需要每一次都进行初始化，需要保存上次连接的状态，用以指示是否为新的http请求
-    // 所以只有当上一次的请求为完成状态时，才回去重新初始化request_成员，以重从开始解析一个http请求
-    if (request_.state() == HttpRequest::FINISH)
-    {
-        request_.init();
-    }
-    // 检查读缓存区中是否存在可读数据
-    if (readBuff_.readableBytes() <= 0)
-    {
-        // 小于等于0表示没有数据可读，直接返回false
-        return false;
-    }
-    // 解析readBuff_中读到的HTTP请求
-    HttpRequest::HTTP_CODE processStatus = request_.parse(readBuff_);
-    // 解析结果为GET_REQUEST获取了完整请求，解析完成，进入回复请求阶段
-    if (processStatus == HttpRequest::GET_REQUEST)
+    while (responseCnt_ < MAX_PIPELINE)
     {
-        // 打印解析的请求路径日志
-        LOG_DEBUG("request path %s", request_.path().c_str());
-        // 初始化一个200 OK的httpresponse对象，包含请求文件路径等信息，负责http应答阶段
-        response_.init(srcDir, request_.path(), request_.isKeepAlive(), 200);
-    }
-    // 解析结果为解析结果为GET_REQUEST请求不完整，应该继续读取请求
-    // 返回false通知调用者继续使用epoll监听该连接上的EPOLLIN读事件
-    else if (processStatus == HttpRequest::NO_REQUEST)
-    {
-        return false;
-    }
-    // 其他情况表示解析失败，初始化一个400错误的httpresponse对象
-    else
-    {
-        response_.init(srcDir, request_.path(), false, 400);
+        // 上一个请求还在等待用户验证，不能重新初始化
+        if (request_.needsVerify())
+        {
+            break;
+        }
+        // 上一个响应发送后就关闭连接，后面的请求不再处理
+        if (responseCnt_ > 0 && !isKeepAlive_)
+        {
+            break;
+        }
+        // 只有当上一次的请求为完成状态时，才重新初始化request_成员，从头开始解析一个新的http请求
+        // 请求不完整时需要保存解析状态，等待剩余数据
+        if (request_.state() == HttpRequest::FINISH)
+        {
+            request_.init();
+        }
+        // 检查读缓存区中是否存在可读数据
+        if (readBuff_.readableBytes() <= 0)
+        {
+            break;
+        }
+        // 解析readBuff_中读到的HTTP请求
+        HttpRequest::HTTP_CODE processStatus = request_.parse(readBuff_);
+        // 解析结果为GET_REQUEST获取了完整请求，解析完成，进入回复请求阶段
+        if (processStatus == HttpRequest::GET_REQUEST)
+        {
+            // 登录或注册请求需要访问数据库，由调用者检查needsVerify()并调度verify()生成响应
+            if (request_.needsVerify())
+            {
+                break;
+            }
+            // 匹配了动态路由的请求交给处理函数生成响应
+            if (request_.route().handler)
+            {
+                routeResponse_();
+            }
+            else
+            {
+                // 打印解析的请求路径日志
+                LOG_DEBUG("request path %s", request_.path().c_str());
+                // 初始化一个200 OK的httpresponse对象，包含请求文件路径等信息，负责http应答阶段
+                makeResponse_(200);
+            }
+        }
+        // 解析结果为NO_REQUEST请求不完整，应该继续读取请求
+        else if (processStatus == HttpRequest::NO_REQUEST)
+        {
+            break;
+        }
+        // 其他情况表示解析失败，初始化一个400错误的httpresponse对象，之后关闭连接
+        else
+        {
+            makeResponse_(400);
+            break;
+        }
     }
+    return responseCnt_ > 0;
+}
+
+/*
+ * 读缓冲区中还有没处理的请求数据，或者有等待验证的请求
+ */
+bool HttpConn::hasPendingRequest() const
+{
+    return readBuff_.readableBytes() > 0 || request_.needsVerify();
+}
+
+/*
+ * 返回解析完成的请求是否需要访问数据库
+ */
+bool HttpConn::needsVerify() const
+{
+    return request_.needsVerify();
+}
+
+/*
+ * 进行用户验证，然后生成响应，验证过程会阻塞在数据库查询上
+ */
+void HttpConn::verify()
+{
+    request_.verify();
+    LOG_DEBUG("request path %s", request_.path().c_str());
+    makeResponse_(200);
+}
+
+/*
+ * 根据状态码初始化httpresponse对象并生成响应，加入待发送队列
+ */
+void HttpConn::makeResponse_(int code)
+{
+    assert(responseCnt_ < MAX_PIPELINE);
+    isKeepAlive_ = code == 200 && request_.isKeepAlive();
+    response_.init(srcDir, request_.path(), isKeepAlive_, code);
     // httpresponse负责拼装返回的头部以及需要发送的文件
     // 注意这里响应数据要存在writeBuff_中，供后续写事件使用，而不是在readBuff_
+    // 响应头追加在前面的响应之后
+    size_t before = writeBuff_.readableBytes();
     response_.makeResponse(writeBuff_);
-    // 响应头（写缓冲区writeBuff_）
-    // 将写缓冲区赋值给iov_，后面使用writev函数发送至客户端
-    iov_[0].iov_base = const_cast<char *>(writeBuff_.peek());
-    iov_[0].iov_len = writeBuff_.readableBytes();
-    iovCnt_ = 1;
+    Response &resp = responses_[(responseHead_ + responseCnt_) % MAX_PIPELINE];
+    resp.headLen = writeBuff_.readableBytes() - before;
+    resp.file = resp.mmFile = nullptr;
+    resp.fileLen = resp.mmFileLen = 0;
     // 响应体（文件内存映射）
-    // 如果需要返回服务器的文件内容，且文件内容不为空
+    // 如果需要返回服务器的文件内容，且文件内容不为空，接管文件映射，发送完成后再解除
     if (response_.fileLen() > 0 && response_.file())
     {
-        // 将文件映射到内存后的地址以及文件长度赋值给iov_变量
-        iov_[1].iov_base = response_.file();
-        iov_[1].iov_len = response_.fileLen();
-        iovCnt_ = 2;
+        resp.mmFileLen = resp.fileLen = response_.fileLen();
+        resp.mmFile = resp.file = response_.releaseFile();
     }
+    responseCnt_++;
+    toWrite_ += resp.headLen + resp.fileLen;
     // 打印响应文件信息日志
-    LOG_DEBUG("filesize: %d, %d to %d", response_.fileLen(), iovCnt_, toWriteBytes());
+    LOG_DEBUG("filesize: %d, %d to %d", resp.mmFileLen, responseCnt_, toWriteBytes());
+}
 
-    return true;
+/*
+ * 调用动态路由的处理函数，响应头和响应体直接写在writeBuff_中前面的响应之后
+ * note: RequestView和ResponseWriter都在栈上，处理函数是函数指针，分发过程没有堆内存分配
+ */
+void HttpConn::routeResponse_()
+{
+    assert(responseCnt_ < MAX_PIPELINE);
+    isKeepAlive_ = request_.isKeepAlive();
+    size_t before = writeBuff_.readableBytes();
+    RequestView view(request_);
+    ResponseWriter writer(writeBuff_, isKeepAlive_, view.method() == "HEAD");
+    request_.route().handler(view, writer);
+    writer.finish();
+    Response &resp = responses_[(responseHead_ + responseCnt_) % MAX_PIPELINE];
+    resp.headLen = writeBuff_.readableBytes() - before;
+    resp.file = resp.mmFile = nullptr;
+    resp.fileLen = resp.mmFileLen = 0;
+    responseCnt_++;
+    toWrite_ += resp.headLen;
+    LOG_DEBUG("route %s: %d, %d to %d", request_.path().c_str(), writer.status(), responseCnt_, toWriteBytes());
+}
+
+/*
+ * 队头的响应出队，解除文件映射
+ */
+void HttpConn::popResponse_()
+{
+    Response &resp = responses_[responseHead_];
+    if (resp.mmFile)
+    {
+        munmap(resp.mmFile, resp.mmFileLen);
+        resp.mmFile = nullptr;
+    }
+    // 没发送完就出队（关闭连接）时，扣除剩余长度并回收响应头占用的空间
+    toWrite_ -= resp.headLen + resp.fileLen;
+    writeBuff_.retrieve(resp.headLen);
+    resp.headLen = resp.fileLen = 0;
+    responseHead_ = (responseHead_ + 1) % MAX_PIPELINE;
+    responseCnt_--;
 }
@@ -9,22 +9,6 @@
  */
 #include "../headers/httprequest.h"
 
-// 保存默认界面名字的静态变量，所有对以下界面的请求都会加上 .html 后缀
-const std::unordered_set<std::string> HttpRequest::DEFAULT_HTML{
-    "/index",
-    "/register",
-    "/login",
-    "/welcome",
-    "/video",
-    "/picture",
-    "/upload",
-    "/success"};
-
-// 静态变量，保存默认的HTML标签
-const std::unordered_map<std::string, int> HttpRequest::DEFAULT_HTML_TAG{
-    {"/register.html", 0},
-    {"/login.html", 1}};
-
 // 上传文件目录
 std::string HttpRequest::uploadDir;
 
@@ -46,14 +30,24 @@ void HttpRequest::init()
     // 状态重置到解析请求首行状态
     state_ = REQUEST_LINE;
     // 清空以下变量
-    header_.clear();
+    raw_.clear();
+    headerCnt_ = 0;
+    scanned_ = 0;
     post_.clear();
-    // 重置是否上传状态，这里必须重置，因为每次请求都会重新init
-    upload_ = false;
+    // 重置上传状态，这里必须重置，因为每次请求都会重新init
+    bodyType_ = BODY_OTHER;
     upload_error_ = false;
-    // 重置记录解析请求体的行数，一定要在这里初始化
-    // 否则如果在parse里初始化，不完整数据下一半来的时候就不知道前面读了几行了
-    parseBodyCnt_ = 0;
+    // 中止没有上传完的文件（连接断开或者请求出错）
+    multipart_.reset();
+    verify_ = false;
+    route_ = nullptr;
+    match_.handler = nullptr;
+    match_.paramCnt = 0;
+    // 重置请求体的读取进度，一定要在这里初始化
+    // 否则如果在parse里初始化，不完整数据下一半来的时候就不知道前面读了多少了
+    contentLength_ = 0;
+    bodyRead_ = 0;
+    isChunked_ = false;
 }
 
 /*
@@ -61,11 +55,54 @@ void HttpRequest::init()
  */
 bool HttpRequest::isKeepAlive() const
 {
-    if (header_.count("Connection") == 1)
+    return header("Connection").equalsIgnoreCase("keep-alive") && version_ == "1.1";
+}
+
+/*
+ * 返回请求是否需要访问数据库
+ * 登录和注册请求在解析完成后只做标记，不在解析时访问数据库，
+ * 这样调用者可以把它们交给单独的线程池，慢查询不会占用处理静态文件请求的工作线程
+ */
+bool HttpRequest::needsVerify() const
+{
+    return verify_;
+}
+
+/*
+ * 返回匹配的动态路由
+ * 路由在解析请求首行后匹配，匹配成功的请求不再补全路径，请求体整体保存，由调用者调用处理函数生成响应
+ */
+const RouteMatch &HttpRequest::route() const
+{
+    return match_;
+}
+
+/*
+ * 进行用户验证，验证成功进入成功页面，失败进入对应的错误页面
+ */
+void HttpRequest::verify()
+{
+    if (!verify_)
+    {
+        return;
+    }
+    verify_ = false;
+    // 进行用户验证，数据库相应操作
+    // 验证成功，进入下一步，设置为成功页面
+    if (userVerify(post_["username"], post_["password"], isLogin_))
     {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1";
+        path_ = "/welcome.html";
+    }
+    // 登录验证失败，设置返回登录错误页面
+    else if (isLogin_)
+    {
+        path_ = "/login_error.html";
+    }
+    // 注册验证失败，设置返回注册错误页面
+    else
+    {
+        path_ = "/register_error.html";
     }
-    return false;
 }
 
 /*
@@ -151,191 +188,429 @@ std::string HttpRequest::getPost(const char *key) const
 }
 
 /*
- * 使用正则库解析请求首行
+ * 返回请求头中指定字段的值，字段名不区分大小写，没有该字段时返回空切片
+ * 字段数很少（通常不到20个），线性查找比哈希表更快，也不需要为每个字段分配内存
+ */
+StringView HttpRequest::header(const StringView &name) const
+{
+    // 请求头还没有解析完成时字段的偏移是相对读缓冲区的，不能用raw_访问
+    if (state_ != BODY && state_ != FINISH)
+    {
+        return StringView();
+    }
+    for (size_t i = 0; i < headerCnt_; i++)
+    {
+        const HeaderField &field = headers_[i];
+        if (StringView(raw_.data() + field.name, field.nameLen).equalsIgnoreCase(name))
+        {
+            return StringView(raw_.data() + field.value, field.valueLen);
+        }
+    }
+    return StringView();
+}
+
+/*
+ * 手写解析请求首行，代替每次构造std::regex再regex_match
  * GET请求的请求首行示例
  * GET /test.jpg HTTP/1.1
  * POST请求的请求首行示例
- * POST / HTTP1.1
+ * POST / HTTP/1.1
+ * 格式：方法 SP URL SP HTTP/版本，方法由token字符组成，URL和版本不能包含空白和控制字符
  */
-bool HttpRequest::parseRequestLine_(const std::string &line)
+bool HttpRequest::parseRequestLine_(const char *begin, const char *end)
 {
-    // note: 正则表达式匹配
-    // 指定匹配规则，^表示行开始，$表示行尾，[^ ]表示匹配非空格
-    // 括号()括住的代表我们需要得到的字符串，最后会送入submatch中
-    // subMatch[0]代表整个字符串的完整匹配结果，subMatch[1...]等代表()中各组匹配结果
-    std::regex pattern("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    std::smatch subMatch;
-    if (std::regex_match(line, subMatch, pattern))
-    {
-        // 解析请求首行获取需要的信息
-        method_ = subMatch[1];
-        path_ = subMatch[2];
-        version_ = subMatch[3];
-        // 切换到下一个状态，即解析请求头
-        state_ = HEADER;
-        return true;
-    }
-    // 没有匹配到说明请求首行格式错误，打印错误日志，返回false
-    LOG_ERROR("RequestLine Error! %s", line.c_str());
-
-    return false;
+    // 方法
+    const char *p = SimdScan::findNonToken(begin, end);
+    const char *methodEnd = p;
+    if (methodEnd == begin || p == end || *p != ' ')
+    {
+        LOG_ERROR("RequestLine Error! %.*s", (int)(end - begin), begin);
+        return false;
+    }
+    // URL
+    const char *path = ++p;
+    p = SimdScan::findSpaceOrCtl(path, end);
+    const char *pathEnd = p;
+    if (pathEnd == path || p == end || *p != ' ')
+    {
+        LOG_ERROR("RequestLine Error! %.*s", (int)(end - begin), begin);
+        return false;
+    }
+    // 版本
+    p++;
+    if (end - p <= 5 || memcmp(p, "HTTP/", 5) != 0)
+    {
+        LOG_ERROR("RequestLine Error! %.*s", (int)(end - begin), begin);
+        return false;
+    }
+    const char *version = p + 5;
+    if (SimdScan::findSpaceOrCtl(version, end) != end)
+    {
+        LOG_ERROR("RequestLine Error! %.*s", (int)(end - begin), begin);
+        return false;
+    }
+    // 解析请求首行获取需要的信息，assign复用string已有的容量
+    method_.assign(begin, methodEnd);
+    path_.assign(path, pathEnd);
+    version_.assign(version, end);
+    // 切换到下一个状态，即解析请求头
+    state_ = HEADER;
+    return true;
 }
 
 /*
- * 使用正则库解析请求头
- * 请求头由如下键值对组成，由 : 分割键值对
- * Host:test.baidu.com
+ * 手写解析请求头的一行
+ * 请求头由如下键值对组成，由 : 分割键值对，值前后的空格和制表符会被去掉
+ * Host: test.baidu.com
+ * 只记录字段名和值相对请求起始位置的偏移，不拷贝
  */
-void HttpRequest::parseHeader_(const std::string &line)
+bool HttpRequest::parseHeader_(const char *begin, const char *end, size_t offset)
 {
-    // 指定匹配规则，^表示行开始，[^:]表示匹配非冒号(:)
-    // ?代表前面的（这里是空格）1次或0次
-    // 括号()括住的代表我们需要得到的字符串，最后会送入submatch中
-    // subMatch[0]代表整个字符串的完整匹配结果，subMatch[1...]等代表()中各组匹配结果
-    std::regex pattern("^([^:]*): ?(.*)$");
-    std::smatch subMatch;
-    if (std::regex_match(line, subMatch, pattern))
+    const char *p = SimdScan::findNonToken(begin, end);
+    // 字段名为空、含有非token字符或者没有冒号，格式错误
+    if (p == begin || p == end || *p != ':' || headerCnt_ == MAX_HEADERS)
+    {
+        LOG_ERROR("Header Error! %.*s", (int)(end - begin), begin);
+        return false;
+    }
+    const char *nameEnd = p++;
+    while (p < end && (*p == ' ' || *p == '\t'))
     {
-        // 将解析出来的信息以键值对的形式存入unordered_map里面
-        header_[subMatch[1]] = subMatch[2];
+        p++;
     }
-    else
+    const char *valueEnd = end;
+    while (valueEnd > p && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t'))
     {
-        // 如果没有匹配到，说明进入到了请求头后的空行
-        // 这里先默认设为解析请求体BODY状态，在调用此函数的函数外可判断method_来判断是POST还是GET请求
-        // 从而转换状态为BODY（POST）还是FINISH（GET）
-        state_ = BODY;
+        valueEnd--;
     }
+    HeaderField &field = headers_[headerCnt_++];
+    field.name = offset;
+    field.nameLen = nameEnd - begin;
+    field.value = offset + (p - begin);
+    field.valueLen = valueEnd - p;
+    return true;
 }
 
 /*
- * 解析请求体
+ * 增量解析请求首行和请求头
+ * 数据直接在读缓冲区中扫描，不按行拷贝成string；数据不完整时记录已经扫描过的长度，下次从断点继续，不会重复扫描，
+ * 也不会在请求首行被拆成多个数据包时误判为格式错误
+ * 读到空行后把整个请求头一次性拷贝到raw_（长连接上复用容量），再从缓冲区中回收，之后请求头字段的切片指向raw_
  */
-bool HttpRequest::parseBody_(const std::string &line)
+HttpRequest::HTTP_CODE HttpRequest::parseHeaders_(Buffer &buff)
 {
-    // 判断是否是上传文件，只进一次，upload_设为true后就不会再进if
-    if (!upload_ && header_["Content-Type"].find("multipart/form-data") != std::string::npos)
+    const char *begin = buff.peek();
+    const char *end = buff.beginWriteConst();
+    const char *lineBegin = begin + scanned_;
+    while (true)
     {
-        upload_ = true;
-        LOG_DEBUG("Upload!");
-        int p = header_["Content-Type"].find("--");
-        header_["boundary"] = header_["Content-Type"].substr(p);
+        // 在请求头的每一行结尾都有\r\n，SIMD查找
+        const char *lineEnd = buff.findCRLF(lineBegin);
+        lineEnd = lineEnd ? lineEnd : end;
+        // 请求头过长
+        if (static_cast<size_t>(lineEnd - begin) > MAX_HEADER_SIZE)
+        {
+            LOG_ERROR("Header Too Large! %zu", (size_t)(lineEnd - begin));
+            return BAD_REQUEST;
+        }
+        // 没有完整的一行，等待更多数据
+        if (lineEnd == end)
+        {
+            scanned_ = lineBegin - begin;
+            return NO_REQUEST;
+        }
+        if (state_ == REQUEST_LINE)
+        {
+            // 请求首行之前的空行忽略（RFC 7230 3.5）
+            if (lineEnd != lineBegin && !parseRequestLine_(lineBegin, lineEnd))
+            {
+                return BAD_REQUEST;
+            }
+        }
+        // 空行，请求头结束
+        else if (lineEnd == lineBegin)
+        {
+            size_t len = lineEnd + 2 - begin;
+            raw_.assign(begin, len);
+            buff.retrieve(len);
+            scanned_ = 0;
+            // 先默认设为解析请求体BODY状态，由调用者根据method_判断是POST还是GET请求
+            state_ = BODY;
+            return GET_REQUEST;
+        }
+        else if (!parseHeader_(lineBegin, lineEnd, lineBegin - begin))
+        {
+            return BAD_REQUEST;
+        }
+        lineBegin = lineEnd + 2;
     }
-    // 将line赋值给类变量body_
-    body_ = line;
-    // 解析请求体行数++
-    parseBodyCnt_++;
-    // 打印读到的请求体日志信息
-    if (!upload_)
+}
+
+/*
+ * 请求头字段name出现的次数（不区分大小写），value为第一次出现时的值，没有出现时为空
+ */
+size_t HttpRequest::headerCount_(const StringView &name, StringView &value) const
+{
+    size_t count = 0;
+    value = StringView();
+    for (size_t i = 0; i < headerCnt_; i++)
     {
-        LOG_DEBUG("UserInfo Body: Usr&Pwd(%s), len(%d)", line.c_str(), line.size());
+        const HeaderField &field = headers_[i];
+        if (StringView(raw_.data() + field.name, field.nameLen).equalsIgnoreCase(name) && count++ == 0)
+        {
+            value = StringView(raw_.data() + field.value, field.valueLen);
+        }
     }
-    else
+    return count;
+}
+
+/*
+ * 请求头解析完成后准备解析请求体
+ * Content-Length必须是十进制数字，没有该字段时请求体长度为0
+ * Content-Length和Transfer-Encoding决定请求体的边界，重复出现、值为空或者同时出现时，
+ * 前后两个服务器可能按不同的边界解析（请求走私），都拒绝（RFC 7230 3.3.2、3.3.3）
+ * 目前只处理POST请求的两种请求体：登录注册的form-urlencoded和上传文件的multipart/form-data，
+ * 动态路由的请求体交给处理函数，其他请求体（包括GET请求带的请求体）读完后丢弃
+ */
+bool HttpRequest::initBody_()
+{
+    StringView length, encoding;
+    size_t lengthCnt = headerCount_("Content-Length", length);
+    size_t encodingCnt = headerCount_("Transfer-Encoding", encoding);
+    contentLength_ = 0;
+    if (lengthCnt > 1 || encodingCnt > 1 || (lengthCnt == 1 && length.empty()))
     {
-        LOG_DEBUG("File UpLoad Body: line%d(%s), len(%d)", parseBodyCnt_, line.c_str(), line.size());
+        LOG_ERROR("Content-Length/Transfer-Encoding Error! %zu %zu", lengthCnt, encodingCnt);
+        return false;
     }
-    // 调用ParsePost_函数解析POST中带的请求体数据
-    // parsePost_()函数返回false代表请求体不完整，继续请求
-    if (!parsePost_())
+    // 只支持chunked一种传输编码，不能同时带Content-Length
+    isChunked_ = encodingCnt == 1;
+    if (isChunked_)
     {
-        return false;
+        if (!encoding.equalsIgnoreCase("chunked") || lengthCnt != 0 || version_ != "1.1")
+        {
+            LOG_ERROR("Transfer-Encoding Error! %.*s", (int)encoding.size(), encoding.data());
+            return false;
+        }
+        chunked_.init();
+    }
+    for (char ch : length)
+    {
+        if (ch < '0' || ch > '9' || contentLength_ > (SIZE_MAX - 9) / 10)
+        {
+            LOG_ERROR("Content-Length Error! %.*s", (int)length.size(), length.data());
+            return false;
+        }
+        contentLength_ = contentLength_ * 10 + (ch - '0');
+    }
+    StringView contentType = header("Content-Type");
+    // 动态路由的请求体不管是什么类型都整体交给处理函数，和表单一样限制长度
+    if (match_.handler)
+    {
+        if (contentLength_ > MAX_FORM_SIZE)
+        {
+            LOG_ERROR("Route Body Too Large! %zu", contentLength_);
+            return false;
+        }
+        bodyType_ = BODY_ROUTE;
+    }
+    else if (method_ == "POST" && contentType == "application/x-www-form-urlencoded")
+    {
+        // 登录注册的表单很短，需要整体保存到内存中解析，限制长度
+        if (contentLength_ > MAX_FORM_SIZE)
+        {
+            LOG_ERROR("Form Too Large! %zu", contentLength_);
+            return false;
+        }
+        bodyType_ = BODY_URLENCODED;
+    }
+    else if (method_ == "POST" && contentType.find("multipart/form-data") != StringView::npos)
+    {
+        // 分隔符为1到70个字符（RFC 2046）
+        StringView boundary = MultipartParser::param(contentType, "boundary");
+        if (boundary.empty() || boundary.size() > 70)
+        {
+            LOG_ERROR("Boundary Error! %.*s", (int)contentType.size(), contentType.data());
+            return false;
+        }
+        bodyType_ = BODY_FORM_DATA;
+        LOG_DEBUG("Upload!");
+        // 判断文件大小（Content-Length），超过上限时只解析不保存，返回错误页面
+        if (contentLength_ > MAX_UPLOAD_SIZE)
+        {
+            // 记录错误标志
+            upload_error_ = true;
+        }
+        multipart_.init(boundary, uploadDir, upload_error_);
+    }
+    else
+    {
+        bodyType_ = BODY_OTHER;
     }
-    // 请求体完整，解析成功，将状态置为FINISH
-    state_ = FINISH;
     return true;
 }
 
 /*
- * 解析请求体中的内容
- * 目前只能解析application/x-www-form-urlencoded此种格式，以后可以根据需要添加格式，比如json
- * 如果请求方式时POST Content-Type为application/x-www-form-urlencoded就可以解析，表示以键值对的数据格式提交
- * 使用POST的形式进行登录信息的传输
+ * 处理一段请求体数据，[data, data + len)是读缓冲区中属于本请求的数据，不会超过Content-Length
+ * 返回处理掉的长度，调用者回收这部分缓冲区；没有处理的数据留在缓冲区中，等更多数据到达后和新数据一起再处理
  */
-bool HttpRequest::parsePost_()
+size_t HttpRequest::parseBody_(const char *data, size_t len, bool last)
 {
-    // 以后可以添加其他种类的Content-Type的支持
-    // 登录业务
-    if (method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded")
+    switch (bodyType_)
     {
-        // 判断POST数据是否接受完整，未接收完则返回false，表示继续请求
-        if (body_.size() < atol(header_["Content-Length"].c_str()))
+    case BODY_URLENCODED:
+        // 整个请求体一次到达时（通常如此）直接在读缓冲区中解析，不拷贝；分多次到达时先拼接到body_
+        if (body_.empty() && last)
         {
-            return false;
+            parseFromUrlencoded_(StringView(data, len));
         }
-        // 将请求体中的内容解析到post_变量中
-        parseFromUrlencoded_();
-        // 用户是否请求的默认DEFAULT_HTML_TAG（登录与注册）网页
-        if (DEFAULT_HTML_TAG.count(path_))
+        else
         {
-            // 获取登录与注册对应的标识
-            // 注意：const的map没有重载[]运算符，所以这里需要用find
-            int tag = DEFAULT_HTML_TAG.find(path_)->second;
-            LOG_DEBUG("Tag: %d", tag);
-            if (tag == 0 || tag == 1)
+            body_.append(data, len);
+            if (last)
             {
-                // 通过标识确定用户请求的是登录还是注册（0注册，1登陆）
-                bool isLogin = (tag == 1);
-                // 进行用户验证，数据库相应操作
-                // 验证成功，进入下一步，设置为成功页面
-                if (userVerify(post_["username"], post_["password"], isLogin))
-                {
-                    path_ = "/welcome.html";
-                }
-                // 登录验证失败，设置返回登录错误页面
-                else if (isLogin)
-                {
-                    path_ = "/login_error.html";
-                }
-                // 注册验证失败，设置返回注册错误页面
-                else
-                {
-                    path_ = "/register_error.html";
-                }
+                parseFromUrlencoded_(body_);
             }
         }
+        return len;
+    case BODY_FORM_DATA:
+        // 流式解析，不完整的部分留在缓冲区中
+        return multipart_.parse(data, len, last);
+    case BODY_ROUTE:
+        // note: body_在init时只清空不释放，长连接上的后续请求复用已分配的容量
+        body_.append(data, len);
+        return len;
+    default:
+        return len;
     }
-    // 上传文件业务
-    else if (method_ == "POST" && upload_)
+}
+
+/*
+ * 分块传输编码的请求体：在缓冲区中原地解码后，解码后的数据和Content-Length请求体一样交给parseBody_
+ * parseBody_没有处理完的数据留在缓冲区开头，解码器把之后的分块数据接在它后面
+ * 请求体长度的上限和Content-Length时相同，超过时直接返回错误（已经开始保存的文件会被删除）
+ */
+HttpRequest::HTTP_CODE HttpRequest::parseChunkedBody_(Buffer &buff)
+{
+    bool ok = chunked_.decode(buff);
+    size_t limit = (bodyType_ == BODY_URLENCODED || bodyType_ == BODY_ROUTE) ? MAX_FORM_SIZE : MAX_UPLOAD_SIZE;
+    if (!ok || chunked_.total() > limit)
+    {
+        LOG_ERROR("Chunked Body Error! %zu", chunked_.total());
+        multipart_.reset();
+        state_ = FINISH;
+        return BAD_REQUEST;
+    }
+    size_t len = chunked_.decoded();
+    bool last = chunked_.finished();
+    size_t used = parseBody_(buff.peek(), len, last);
+    bodyRead_ += used;
+    if (!last)
+    {
+        chunked_.consume(used);
+        buff.retrieve(used);
+        return NO_REQUEST;
+    }
+    // 请求体结束，之后的数据属于流水线上的下一个请求
+    buff.retrieve(len);
+    chunked_.consume(len);
+    contentLength_ = bodyRead_;
+    if (!parseTrailer_())
+    {
+        multipart_.reset();
+        state_ = FINISH;
+        return BAD_REQUEST;
+    }
+    return finishBody_();
+}
+
+/*
+ * 把分块传输编码的尾部字段合并到请求头中，之后和普通请求头一样可以通过header()访问
+ * 尾部不能出现和报文格式、路由、连接管理相关的字段（RFC 7230 4.1.2），请求体已经按请求头处理完，这些字段忽略
+ */
+bool HttpRequest::parseTrailer_()
+{
+    static const char *const IGNORED[] = {"Content-Length", "Transfer-Encoding", "Trailer", "Host", "Connection", "Content-Type"};
+    const std::string &trailer = chunked_.trailer();
+    size_t pos = 0;
+    while (pos < trailer.size())
     {
-        // 判断文件大小（Content-Length），超过30M直接返回错误
-        if (strtoll(header_["Content-Length"].c_str(), nullptr, 10) > 30 * 1024 * 1024)
+        size_t lineEnd = trailer.find("\r\n", pos);
+        StringView line(trailer.data() + pos, lineEnd - pos);
+        StringView name = line.substr(0, line.find(":"));
+        bool ignored = false;
+        for (const char *field : IGNORED)
         {
-            // 记录错误标志
-            upload_error_ = true;
+            ignored = ignored || name.equalsIgnoreCase(field);
         }
-        bool ret = parseFormData_();
-        // 上传成功
-        if (ret)
+        if (!ignored)
         {
-            // 跳转失败页面
-            if (upload_error_)
+            size_t offset = raw_.size();
+            raw_.append(line.data(), line.size());
+            if (!parseHeader_(raw_.data() + offset, raw_.data() + raw_.size(), offset))
             {
-                path_ = "/upload_error.html";
+                return false;
             }
-            // 跳转成功页面
-            else
-            {
-                path_ = "/success.html";
-            }
-            return true;
         }
-        // 上传不完整
-        else
+        pos = lineEnd + 2;
+    }
+    return true;
+}
+
+/*
+ * 请求体接收完成
+ * 登录和注册请求标记需要用户验证，上传文件请求根据结果设置返回的页面
+ */
+HttpRequest::HTTP_CODE HttpRequest::finishBody_()
+{
+    // 用户请求的是否是注册了登录或注册处理函数的路由
+    // 这里只标记需要用户验证，访问数据库在verify()中进行；其他处理函数（包括NONE）不需要验证，只返回文件
+    if (bodyType_ == BODY_URLENCODED && route_)
+    {
+        switch (route_->handler)
         {
-            return false;
+        case RouteTable::LOGIN:
+            isLogin_ = true;
+            verify_ = true;
+            break;
+        case RouteTable::REGISTER:
+            isLogin_ = false;
+            verify_ = true;
+            break;
+        default:
+            break;
         }
+        LOG_DEBUG("Handler: %d, Verify: %d", route_->handler, verify_);
     }
-    return true;
+    else if (bodyType_ == BODY_FORM_DATA)
+    {
+        // 请求体已经读完，但是没有结束分隔行，格式错误，删除没有上传完的文件
+        if (!multipart_.finished())
+        {
+            LOG_ERROR("Body Incomplete! %zu", contentLength_);
+            multipart_.reset();
+            state_ = FINISH;
+            return BAD_REQUEST;
+        }
+        // 有文件保存失败或者没有文件时跳转失败页面，否则跳转成功页面
+        upload_error_ = upload_error_ || multipart_.error() || multipart_.files() == 0;
+        path_ = upload_error_ ? "/upload_error.html" : "/success.html";
+    }
+    // 请求体完整，解析成功，将状态置为FINISH
+    state_ = FINISH;
+    return GET_REQUEST;
 }
 
 /*
  * 从请求体中的application/x-www-form-urlencoded类型信息提取信息
  * 示例：username=test&password=test
  */
-void HttpRequest::parseFromUrlencoded_()
+void HttpRequest::parseFromUrlencoded_(const StringView &body)
 {
+    // 打印读到的请求体日志信息
+    LOG_DEBUG("UserInfo Body: Usr&Pwd(%.*s), len(%zu)", (int)body.size(), body.data(), body.size());
     // 请求体大小=0，直接返回
-    int n = body_.size();
+    size_t n = body.size();
     if (n == 0)
     {
         return;
@@ -344,9 +619,9 @@ void HttpRequest::parseFromUrlencoded_()
     std::string key, value, temp;
     int num = 0;
     // 遍历整个请求体大小
-    for (int i = 0; i < n; i++)
+    for (size_t i = 0; i < n; i++)
     {
-        char ch = body_[i];
+        char ch = body[i];
         switch (ch)
         {
         case '=':
@@ -362,7 +637,13 @@ void HttpRequest::parseFromUrlencoded_()
             // 浏览器会将非字母字符，encode成百分号+其ASCII码的十六进制
             // %后面跟的是十六进制码，将十六进制转化为10进制
             // 这里应该是转成ASCII码对应的字符，而不是转换成对应的十进制字符，况且转化后的十进制也只能局限在0-99范围内
-            num = convertHex(body_[i + 1]) * 16 + convertHex(body_[i + 2]);
+            // %后面不足两个字符时不转换，避免越界
+            if (i + 2 >= n)
+            {
+                temp += ch;
+                break;
+            }
+            num = convertHex(body[i + 1]) * 16 + convertHex(body[i + 2]);
             // 根据ascii码转换为字符
             temp += static_cast<char>(num);
             // 向后移动两个位置
@@ -389,79 +670,6 @@ void HttpRequest::parseFromUrlencoded_()
     }
 }
 
-/*
- * 从请求体中的multipart/form-data类型信息提取信息，用类似有限状态自动机，根据parseBodyCnt_和body头和body结尾判断结束
- * 示例：
- * ------WebKitFormBoundaryT2H3ppmKTEsin6D1
- * Content-Disposition: form-data; name="file"; filename="test.txt"
- * Content-Type: text/plain
- * 空行
- * 文件内容
- * ------WebKitFormBoundaryT2H3ppmKTEsin6D1--
- */
-bool HttpRequest::parseFormData_()
-{
-    // 第2行是文件信息
-    if (parseBodyCnt_ == 2)
-    {
-        // 取文件名
-        auto p = body_.find("filename");
-        // 取从"开始
-        uploadFilename_ = body_.substr(p + 10);
-        // 去掉后面的"
-        uploadFilename_ = uploadFilename_.substr(0, uploadFilename_.size() - 1);
-        // 取文件后缀
-        p = uploadFilename_.find(".");
-        // 未找到后缀，直接返回格式错误
-        if (p == uploadFilename_.npos)
-        {
-            upload_error_ = true;
-            return false;
-        }
-        std::string suffix = uploadFilename_.substr(p + 1);
-        // 后缀不是txt
-        if (suffix != "txt")
-        {
-            upload_error_ = true;
-            return false;
-        }
-        // 文件格式验证通过
-        if (!upload_error_)
-        {
-            // 增加路径前缀
-            uploadFilename_ = uploadDir + uploadFilename_;
-            // 打开文件
-            // note: fopen和open有区别
-            fp_ = fopen(uploadFilename_.c_str(), "w");
-        }
-        return false;
-    }
-    // 第5行以后都是文件内容，后面body_的判断是防止空文件
-    else if (parseBodyCnt_ >= 5 && body_ != "--" + header_["boundary"] + "--")
-    {
-        if (!upload_error_)
-        {
-            // 将请求体的上传文件数据写入文件
-            fputs(body_.c_str(), fp_);
-            // 刷新缓冲区（若没有及时刷新，内核可能会延迟一段时间才将缓存区数据写到磁盘）
-            fflush(fp_);
-        }
-        return false;
-    }
-    // 最后一行是结尾
-    else if (body_ == "--" + header_["boundary"] + "--")
-    {
-        if (!upload_error_)
-        {
-            // 在关闭时fopen和open也有区别
-            fclose(fp_);
-        }
-        return true;
-    }
-    // 其他情况继续读取，可能是空行等
-    return false;
-}
-
 /*
  * 验证用户
  */
@@ -566,129 +774,127 @@ bool HttpRequest::userVerify(const std::string &name, const std::string &pwd, bo
 }
 
 /*
- * 将客户端传来的path变量添加完整，以目录结束的路径添加上默认页面
- * 在DEFAULT_HTML中的界面添加上文件后缀名
+ * 在路由表中查找请求路径（一次散列、一次比较），页面别名替换为实际的文件路径
+ * 根目录和默认界面都在路由表中注册，不在表中的路径按原样作为静态文件
  */
 void HttpRequest::parsePath_()
 {
-    if (path_ == "/")
+    route_ = RouteTable::find(path_);
+    if (route_ && route_->target)
     {
-        path_ = "/index.html";
+        path_ = route_->target;
     }
-    else
+}
+
+/*
+ * 是否可以把socket中的数据直接splice到上传文件
+ * 缓冲区中没有处理的数据（解析器留下的不足一次写入的文件内容）必须都属于本请求体，剩下的请求体除去结尾部分还要足够长
+ */
+bool HttpRequest::canSplice(const Buffer &buff) const
+{
+    return state_ == BODY && !isChunked_ && bodyType_ == BODY_FORM_DATA && multipart_.canSplice() &&
+           contentLength_ - bodyRead_ >= buff.readableBytes() + SPLICE_TAIL + SPLICE_MIN;
+}
+
+/*
+ * 上传大文件时文件内容不经过读缓冲区：先把缓冲区中剩下的文件内容写入文件，再从socket经管道splice到文件
+ * 不能确定splice的数据中没有分隔行（可能还有其他部分），由解析器检查，找到时分隔行之后的数据放回buff按普通方式解析
+ * 请求体最后SPLICE_TAIL字节不splice，结束分隔行总是在缓冲区中解析；此时文件末尾可能是分隔行前缀的数据也移回buff
+ */
+ssize_t HttpRequest::splice(int sockFd, Buffer &buff, int *saveErrno)
+{
+    size_t held = buff.readableBytes();
+    multipart_.flush(buff.peek(), held);
+    buff.retrieve(held);
+    bodyRead_ += held;
+    // 写文件失败时解析器已经删除文件，剩下的文件内容按普通方式读取丢弃
+    if (!multipart_.canSplice())
     {
-        for (auto &item : DEFAULT_HTML)
-        {
-            if (item == path_)
-            {
-                path_ += ".html";
-                break;
-            }
-        }
+        return buff.readFd(sockFd, saveErrno);
     }
+    ssize_t len = multipart_.splice(sockFd, contentLength_ - bodyRead_ - SPLICE_TAIL, saveErrno);
+    if (len > 0)
+    {
+        bodyRead_ += len;
+    }
+    // 放回缓冲区的数据还没有解析，不计入已读取的请求体
+    bodyRead_ -= multipart_.verify(buff);
+    if (multipart_.canSplice() && contentLength_ - bodyRead_ < SPLICE_TAIL + SPLICE_MIN)
+    {
+        bodyRead_ -= multipart_.unsplice(buff);
+    }
+    return len;
 }
 
 /*
  * 解析收到的http请求内容
- * 作者实现有点问题，需要改进，可以按照tinywebserver的解析方式进行改进
+ * 请求首行和请求头由parseHeaders_增量解析，请求体按Content-Length作为字节流处理
  */
 HttpRequest::HTTP_CODE HttpRequest::parse(Buffer &buff)
 {
-    // 在请求头的每一行结尾都有\r\n
-    const char CRLF[] = "\r\n";
     // note: 若没有内容可以被读取，不能直接返回false
     // 应该返回一个NO_REQUEST状态，调用函数接受到该状态之后重新修改epoll事件注册一个EPOLLIN事件继续读
     if (buff.readableBytes() <= 0)
     {
         return NO_REQUEST;
     }
-    // 状态机方式解析http请求头，只要可读并且没有解析完成就继续循环
-    // 在BODY状态，如果可读，说明在缓冲区中有多行数据
-    // 如果不可读说明网络传输了一部分，此时跳出while循环，返回NO_REQUEST，重新注册EPOLLIN事件，等待接收剩余数据
-    while (buff.readableBytes() && state_ != FINISH)
-    {
-        // 首先通过查找CRLF标志找到一行的结尾
-        // note: search用于在序列A中查找序列B第一次出现的位置，如果未找到，返回last迭代器，也就是buff.beginWriteConst()
-        // lineEnd指针会指向\r位置，也就是有效字符串的后一个位置
-        // 当序列A中没有序列B中的字符时，会返回序列A的尾后指针
-        // 这里用变量记录，方便switch后判断是否完整，即是否查到了CRLF
-        const char *rdp = buff.peek();
-        const char *wdp = buff.beginWriteConst();
-        const char *lineEnd = std::search(rdp, wdp, CRLF, CRLF + 2);
-        // 根据查找到的行尾的位置初始化一个行字符串
-        std::string line(rdp, lineEnd);
-        // 若解析状态停留在HEADER且没有CRLF作为结尾（未找到CRLF）
-        // 直接退出循环，返回NO_REQUEST请求不完整，直到接收完整数据
-        // 因为是header，如果不完整，无法解析，而body可以先接受一部分
-        if (lineEnd == wdp && state_ == HEADER)
+    if (state_ == REQUEST_LINE || state_ == HEADER)
+    {
+        HTTP_CODE ret = parseHeaders_(buff);
+        // 格式错误，丢弃已解析的字段，置为完成状态，下一次process时重新初始化
+        if (ret == BAD_REQUEST)
         {
-            break;
+            headerCnt_ = 0;
+            state_ = FINISH;
+            return ret;
         }
-        // 开始解析
-        switch (state_)
+        // 请求头不完整
+        if (ret != GET_REQUEST)
+        {
+            return ret;
+        }
+        // 打印请求首行日志信息
+        LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+        // 先匹配动态路由（原始路径），没有匹配时按静态路由表补全路径
+        if (!Router::instance()->match(method_, path_, match_))
         {
-        case REQUEST_LINE:
-            // 首先解析请求首行
-            if (!parseRequestLine_(line))
-            {
-                // 如果失败的话，返回BAD_REQUEST
-                return BAD_REQUEST;
-            }
-            // 将客户端传来的path变量添加完整,目录加上默认页面，没有后缀的指定文件加上后缀
             parsePath_();
-            // 这里break是退出switch，不是退出循环，要继续解析
-            break;
-        case HEADER:
-            // 解析完请求首行之后，state_变量会被置为HEADERS，所以会跳到此处解析请求头部
-            parseHeader_(line);
-            // note: 因为可能会存在请求未接受完整的情况，所以后面可以改成根据method_判断是否跳转到FINISH阶段
-            // 因为在ParseHeader_中请求头解析到空行时会将state_置为BODY
-            // 所以这里的判断条件可以改为 if(state_==body && method_==GET){state_=FINISH;}
-            // 这样就可以实现GET与POST的对应处理
-            // 如果是POST请求，则将state_设置为BODY进入解析请求体的流程
-            // 如果是GET请求，则将state_设置为FINISH状态结束解析
-            if (state_ == BODY && method_ == "GET")
-            {
-                // 状态改为完成
-                state_ = FINISH;
-                // 读完所有，回收空间
-                buff.retrieveAll();
-                // 返回GET_REQUEST获取完整请求
-                return GET_REQUEST;
-            }
-            // 同上，继续循环解析
-            break;
-        case BODY:
-            // 解析完请求首行之后，若是POST请求则会进入解析请求体这一步
-            // 如果请求体数据不完整，parseBody_()函数返回false
-            if (!parseBody_(line))
-            {
-                // 请求体没有读完整，可能还在缓冲区中有多行数据，也可能网络传输了一部分，break出switch到while循环判断
-                break;
-            }
-            // 完整请求体，回收空间
-            buff.retrieveAll();
-            // 返回GET_REQUEST获取完整请求
-            return GET_REQUEST;
-        default:
-            // 默认返回INTERNAL_ERROR服务器内部错误，一般不会进
-            return INTERNAL_ERROR;
         }
-        // 移动读指针到下一行，跳过上一行的\r\n
-        // 这里一定要注意，因为可能没找到\r\n，就不能跳过\r\n
-        // 若解析状态停留在BODY且没有CRLF作为结尾（未找到CRLF）
-        if (lineEnd == wdp && state_ == BODY)
+        // 准备解析请求体，Content-Length格式错误或者表单过长时返回错误
+        // note: 不论什么方法都按Content-Length或分块传输编码确定请求体的边界，GET等请求带的请求体读完后丢弃，
+        // 否则请求体会被当作流水线上的下一个请求解析（请求走私）
+        if (!initBody_())
         {
-            buff.retrieveUntil(lineEnd);
+            state_ = FINISH;
+            return BAD_REQUEST;
         }
-        // 读到了完整body，找打了\r\n
-        else
+        // 没有请求体，将state_设置为FINISH状态结束解析
+        // note: 请求头已经在parseHeaders_中回收，缓冲区中剩下的是流水线上的后续请求，不能丢弃
+        if (!isChunked_ && contentLength_ == 0 && bodyType_ != BODY_URLENCODED && bodyType_ != BODY_FORM_DATA)
+        {
+            state_ = FINISH;
+            return GET_REQUEST;
+        }
+    }
+    // 分块传输编码的请求体没有Content-Length，到最后一个分块为止
+    if (state_ == BODY && isChunked_)
+    {
+        return parseChunkedBody_(buff);
+    }
+    // 请求体按字节流处理：缓冲区中属于本请求的数据（最多到Content-Length）一次交给parseBody_，处理掉的部分立即回收
+    // 不再按行拷贝成string，请求体可以是任意数据，也可以没有换行；Content-Length之后的数据属于流水线上的下一个请求
+    if (state_ == BODY)
+    {
+        size_t len = std::min(buff.readableBytes(), contentLength_ - bodyRead_);
+        size_t used = parseBody_(buff.peek(), len, bodyRead_ + len == contentLength_);
+        bodyRead_ += used;
+        buff.retrieve(used);
+        // 请求体接收完成
+        if (bodyRead_ == contentLength_)
         {
-            buff.retrieveUntil(lineEnd + 2);
+            return finishBody_();
         }
     }
-    // 打印请求首行日志信息
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
-    // note: 最后直接返回NO_REQUEST状态，表示如果执行到这一部分，说明请求没有接受完整，需要继续接受请求，若是请求完整的在之前就会return出while
+    // note: 最后直接返回NO_REQUEST状态，表示请求没有接受完整，需要继续接受请求
     return NO_REQUEST;
-}
\ No newline at end of file
+}
@@ -92,6 +92,17 @@ char *HttpResponse::file()
     return mmFile_;
 }
 
+/*
+ * 交出文件的内存映射，init时不会再解除该映射
+ * 流水线请求的多个响应同时等待发送，每个响应的映射由HttpConn保存到发送完成
+ */
+char *HttpResponse::releaseFile()
+{
+    char *file = mmFile_;
+    mmFile_ = nullptr;
+    return file;
+}
+
 /*
  * 返回文件大小
  */
@@ -266,13 +277,14 @@ void HttpResponse::makeResponse(Buffer &buff)
     // 判断请求的资源文件
     // 如果服务器上无法找到请求的资源或者是目录（在请求中已经将连接的默认文件补充完整，如果还是目录说明错误）
     // note: stat用来将参数file_name所指的文件状态, 复制到参数mmFileStat_所指的结构中。若执行失败，即返回值为-1
-    if (stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode))
+    // 请求解析失败（400）时路径不一定是文件（比如动态路由），不检查请求的资源，保持400
+    if (code_ != 400 && (stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)))
     {
         // 返回404 NOT FOUND错误
         code_ = 404;
     }
     // 请求的资源没有读取权限，访问被服务器拒绝，置状态码code_为403
-    else if (!(mmFileStat_.st_mode & S_IROTH))
+    else if (code_ != 400 && !(mmFileStat_.st_mode & S_IROTH))
     {
         // 返回403 Forbidden错误
         code_ = 403;
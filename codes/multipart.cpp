@@ -0,0 +1,594 @@
+#include "../headers/multipart.h"
+
+const size_t MultipartParser::PIPE_SIZE; // 传给std::min时按引用使用，需要定义
+
+/*
+ * 构造函数
+ */
+MultipartParser::MultipartParser() : state_(FAILED), discard_(true), atStart_(false), error_(false), files_(0),
+                                     headerLen_(0), scanned_(0), fd_(-1), fileOff_(0), spliced_(false), verifyFrom_(0),
+                                     map_(nullptr), mapOff_(0)
+{
+    pipe_[0] = pipe_[1] = -1;
+}
+
+/*
+ * 析构函数，没有上传完的文件会被删除
+ */
+MultipartParser::~MultipartParser()
+{
+    reset();
+}
+
+/*
+ * 开始解析一个请求体
+ * 请求体中的分隔行是"--分隔符"，除了第一个以外前面都有CRLF，所以查找"\r\n--分隔符"，文件内容中的换行不会被误判
+ */
+void MultipartParser::init(const StringView &boundary, const std::string &dir, bool discard)
+{
+    reset();
+    needle_.assign("\r\n--");
+    needle_.append(boundary.data(), boundary.size());
+    dir_ = dir;
+    discard_ = discard;
+    atStart_ = true;
+    error_ = false;
+    files_ = 0;
+    headerLen_ = 0;
+    scanned_ = 0;
+    filename_.clear();
+    fileOff_ = 0;
+    spliced_ = false;
+    state_ = PREAMBLE;
+}
+
+/*
+ * 中止解析，连接断开或者请求体不完整时，关闭并删除没有上传完的文件
+ */
+void MultipartParser::reset()
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        unlink(path_.c_str());
+        fd_ = -1;
+        LOG_WARN("Upload Aborted! %s", path_.c_str());
+    }
+    unmap_();
+    // 管道中可能还有没移动到文件的数据，直接关闭
+    if (pipe_[0] >= 0)
+    {
+        close(pipe_[0]);
+        close(pipe_[1]);
+        pipe_[0] = pipe_[1] = -1;
+    }
+    spliced_ = false;
+    state_ = FAILED;
+}
+
+/*
+ * 是否已经读到结束分隔行
+ */
+bool MultipartParser::finished() const
+{
+    return state_ == EPILOGUE;
+}
+
+/*
+ * 是否有部分格式错误或者保存失败
+ */
+bool MultipartParser::error() const
+{
+    return error_;
+}
+
+/*
+ * 保存成功的文件数
+ */
+int MultipartParser::files() const
+{
+    return files_;
+}
+
+/*
+ * 当前是否在写文件内容，可以改为splice
+ */
+bool MultipartParser::canSplice() const
+{
+    return state_ == PART_DATA && fd_ >= 0;
+}
+
+/*
+ * 开始或继续splice之前，把调用者缓冲区中还没处理的文件内容写入文件，之后的数据从socket直接splice到文件
+ * 这部分数据末尾可能是分隔行的前缀，所以从它开始和之后splice的数据一起检查
+ */
+void MultipartParser::flush(const char *data, size_t len)
+{
+    if (!spliced_)
+    {
+        spliced_ = true;
+        verifyFrom_ = fileOff_;
+    }
+    writePart_(data, len);
+    scanned_ = 0;
+}
+
+/*
+ * 从socket经管道splice最多len字节到文件：socket到管道只是引用内核中的数据页，管道到文件由内核拷贝到页缓存，不经过用户态
+ * 每次最多移动一个管道容量，移动之后管道是空的；写文件失败时管道中的数据已经丢失，请求体无法继续解析
+ */
+ssize_t MultipartParser::splice(int sockFd, size_t len, int *saveErrno)
+{
+    if (pipe_[0] < 0)
+    {
+        if (pipe2(pipe_, O_CLOEXEC | O_NONBLOCK) < 0)
+        {
+            *saveErrno = errno;
+            pipe_[0] = pipe_[1] = -1;
+            return -1;
+        }
+        // 管道容量默认64KB，调大可以减少系统调用，失败（超过/proc/sys/fs/pipe-max-size）时用默认值
+        fcntl(pipe_[1], F_SETPIPE_SZ, static_cast<int>(PIPE_SIZE));
+    }
+    ssize_t n = ::splice(sockFd, nullptr, pipe_[1], nullptr, std::min(len, PIPE_SIZE), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n <= 0)
+    {
+        if (n < 0)
+        {
+            *saveErrno = errno;
+        }
+        return n;
+    }
+    size_t left = n;
+    while (left > 0)
+    {
+        ssize_t m = ::splice(pipe_[0], nullptr, fd_, nullptr, left, SPLICE_F_MOVE);
+        if (m < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (m <= 0)
+        {
+            LOG_ERROR("Upload Splice Error! %s, errno: %d", path_.c_str(), errno);
+            fail_("Splice Failed");
+            return n;
+        }
+        fileOff_ += m;
+        left -= m;
+    }
+    return n;
+}
+
+/*
+ * 检查splice到文件的数据中有没有分隔行：把还没检查的部分映射到内存中查找，数据刚写入，还在页缓存中
+ * 没有找到时，末尾needle_.size() - 1字节可能是分隔行的前缀，下次和新数据一起检查
+ * 找到时（后面还有其他部分或者已经到结束分隔行），文件截断到分隔行为止，之后的数据追加到buff由调用者继续解析
+ */
+size_t MultipartParser::verify(Buffer &buff)
+{
+    if (!spliced_ || fd_ < 0 || static_cast<size_t>(fileOff_ - verifyFrom_) < needle_.size())
+    {
+        return 0;
+    }
+    // 每次映射MAP_WINDOW大小的窗口，之后splice的数据在窗口内时不需要重新映射（只访问文件长度以内的部分）
+    if (map_ == nullptr || fileOff_ > mapOff_ + static_cast<off_t>(MAP_WINDOW))
+    {
+        unmap_();
+        mapOff_ = verifyFrom_ / PAGE_SIZE * PAGE_SIZE;
+        void *map = mmap(nullptr, MAP_WINDOW, PROT_READ, MAP_SHARED, fd_, mapOff_);
+        if (map == MAP_FAILED)
+        {
+            LOG_ERROR("Upload Mmap Error! %s, errno: %d", path_.c_str(), errno);
+            fail_("Verify Failed");
+            return 0;
+        }
+        map_ = static_cast<char *>(map);
+    }
+    const char *end = map_ + (fileOff_ - mapOff_);
+    const char *delim = SimdScan::find(map_ + (verifyFrom_ - mapOff_), end, needle_.data(), needle_.size());
+    size_t back = 0;
+    if (delim == end)
+    {
+        verifyFrom_ = fileOff_ - (needle_.size() - 1);
+    }
+    else
+    {
+        const char *rest = delim + needle_.size();
+        back = end - rest;
+        buff.append(rest, back);
+        fileOff_ = mapOff_ + (delim - map_);
+        if (ftruncate(fd_, fileOff_) < 0)
+        {
+            LOG_ERROR("Upload Truncate Error! %s, errno: %d", path_.c_str(), errno);
+            error_ = true;
+            reset();
+        }
+        spliced_ = false;
+        endPart_();
+        scanned_ = 0;
+        state_ = DELIMITER_TAIL;
+    }
+    return back;
+}
+
+/*
+ * 结束splice（剩下的请求体只有结尾部分），文件末尾还没检查的数据可能是分隔行的前缀，从文件中移回buff，和之后读到的数据一起解析
+ * 调用者的缓冲区此时是空的，移回的数据不超过needle_.size() - 1字节
+ */
+size_t MultipartParser::unsplice(Buffer &buff)
+{
+    if (!spliced_ || fd_ < 0)
+    {
+        spliced_ = false;
+        return 0;
+    }
+    spliced_ = false;
+    unmap_();
+    char tail[128];
+    size_t back = fileOff_ - verifyFrom_;
+    if (back > sizeof(tail) || pread(fd_, tail, back, verifyFrom_) != static_cast<ssize_t>(back) ||
+        ftruncate(fd_, verifyFrom_) < 0 || lseek(fd_, verifyFrom_, SEEK_SET) < 0)
+    {
+        LOG_ERROR("Upload Unsplice Error! %s, errno: %d", path_.c_str(), errno);
+        fail_("Unsplice Failed");
+        return 0;
+    }
+    buff.append(tail, back);
+    fileOff_ = verifyFrom_;
+    scanned_ = 0;
+    return back;
+}
+
+/*
+ * 从字段值中取出参数的值，参数名不区分大小写，值可以带引号
+ * 示例：form-data; name="file"; filename="test.txt" 中取filename得到test.txt
+ *      multipart/form-data; boundary=----WebKitFormBoundaryT2H3ppmKTEsin6D1 中取boundary
+ */
+StringView MultipartParser::param(const StringView &value, const StringView &name)
+{
+    size_t pos = value.find(";");
+    while (pos != StringView::npos)
+    {
+        pos++;
+        while (pos < value.size() && (value[pos] == ' ' || value[pos] == '\t'))
+        {
+            pos++;
+        }
+        size_t eq = value.find("=", pos);
+        if (eq == StringView::npos)
+        {
+            break;
+        }
+        StringView key = value.substr(pos, eq - pos);
+        while (!key.empty() && (key[key.size() - 1] == ' ' || key[key.size() - 1] == '\t'))
+        {
+            key = key.substr(0, key.size() - 1);
+        }
+        StringView val;
+        size_t next;
+        // 带引号的值可以包含;
+        if (eq + 1 < value.size() && value[eq + 1] == '"')
+        {
+            size_t quote = value.find("\"", eq + 2);
+            if (quote == StringView::npos)
+            {
+                break;
+            }
+            val = value.substr(eq + 2, quote - eq - 2);
+            next = value.find(";", quote);
+        }
+        else
+        {
+            next = value.find(";", eq + 1);
+            val = value.substr(eq + 1, next == StringView::npos ? StringView::npos : next - eq - 1);
+            while (!val.empty() && (val[val.size() - 1] == ' ' || val[val.size() - 1] == '\t'))
+            {
+                val = val.substr(0, val.size() - 1);
+            }
+        }
+        if (key.equalsIgnoreCase(name))
+        {
+            return val;
+        }
+        pos = next;
+    }
+    return StringView();
+}
+
+/*
+ * 解析一段请求体数据，依次运行各状态的处理函数，直到需要更多数据
+ * 返回处理掉的长度，没有处理的数据（不完整的行、可能是分隔行前缀的末尾、还没攒够的文件内容）由调用者保留，下次和新数据一起传入
+ */
+size_t MultipartParser::parse(const char *data, size_t len, bool last)
+{
+    const char *p = data;
+    const char *end = data + len;
+    bool more = true;
+    while (more)
+    {
+        switch (state_)
+        {
+        case PREAMBLE:
+            more = parsePreamble_(p, end, last);
+            break;
+        case DELIMITER_TAIL:
+            more = parseDelimiterTail_(p, end);
+            break;
+        case PART_HEADER:
+            more = parsePartHeader_(p, end);
+            break;
+        case PART_DATA:
+            more = parsePartData_(p, end, last);
+            break;
+        // 结束或出错之后的数据全部忽略
+        default:
+            p = end;
+            more = false;
+            break;
+        }
+    }
+    return p - data;
+}
+
+/*
+ * 跳过第一个分隔行之前的内容，请求体通常直接以"--分隔符"开头
+ */
+bool MultipartParser::parsePreamble_(const char *&p, const char *end, bool last)
+{
+    size_t first = needle_.size() - 2;
+    if (atStart_)
+    {
+        if (static_cast<size_t>(end - p) < first)
+        {
+            if (last)
+            {
+                fail_("Body Too Short");
+                return true;
+            }
+            return false;
+        }
+        atStart_ = false;
+        if (memcmp(p, needle_.data() + 2, first) == 0)
+        {
+            p += first;
+            state_ = DELIMITER_TAIL;
+            return true;
+        }
+    }
+    const char *delim = SimdScan::find(p, end, needle_.data(), needle_.size());
+    if (delim == end)
+    {
+        if (last)
+        {
+            fail_("No Boundary");
+            return true;
+        }
+        // 末尾可能是分隔行的前缀，留下needle_.size() - 1字节
+        if (static_cast<size_t>(end - p) >= needle_.size())
+        {
+            p = end - (needle_.size() - 1);
+        }
+        return false;
+    }
+    p = delim + needle_.size();
+    state_ = DELIMITER_TAIL;
+    return true;
+}
+
+/*
+ * 分隔行之后是"--"表示整个请求体结束，否则到CRLF为止（中间只能有空白填充）之后是下一个部分的部分头
+ */
+bool MultipartParser::parseDelimiterTail_(const char *&p, const char *end)
+{
+    if (end - p < 2)
+    {
+        return false;
+    }
+    if (p[0] == '-' && p[1] == '-')
+    {
+        p += 2;
+        state_ = EPILOGUE;
+        return true;
+    }
+    const char *lineEnd = SimdScan::findCRLF(p, end);
+    if (lineEnd == end)
+    {
+        if (static_cast<size_t>(end - p) > MAX_DELIMITER_TAIL)
+        {
+            fail_("Bad Delimiter");
+            return true;
+        }
+        return false;
+    }
+    for (const char *c = p; c < lineEnd; c++)
+    {
+        if (*c != ' ' && *c != '\t')
+        {
+            fail_("Bad Delimiter");
+            return true;
+        }
+    }
+    p = lineEnd + 2;
+    headerLen_ = 0;
+    filename_.clear();
+    state_ = PART_HEADER;
+    return true;
+}
+
+/*
+ * 逐行解析部分头，只关心Content-Disposition中的filename，空行表示部分头结束
+ */
+bool MultipartParser::parsePartHeader_(const char *&p, const char *end)
+{
+    const char *lineEnd = SimdScan::findCRLF(p, end);
+    if (lineEnd == end)
+    {
+        if (headerLen_ + (end - p) > MAX_PART_HEADER)
+        {
+            fail_("Part Header Too Large");
+            return true;
+        }
+        return false;
+    }
+    // 空行，部分头结束
+    if (lineEnd == p)
+    {
+        p += 2;
+        beginPart_();
+        scanned_ = 0;
+        state_ = PART_DATA;
+        return true;
+    }
+    StringView line(p, lineEnd - p);
+    size_t colon = line.find(":");
+    if (colon == StringView::npos)
+    {
+        fail_("Bad Part Header");
+        return true;
+    }
+    if (line.substr(0, colon).equalsIgnoreCase("Content-Disposition"))
+    {
+        filename_ = param(line.substr(colon + 1), "filename").toString();
+    }
+    headerLen_ += lineEnd + 2 - p;
+    p = lineEnd + 2;
+    return true;
+}
+
+/*
+ * 查找下一个分隔行，之前的内容写入文件
+ * 没有找到时，末尾needle_.size() - 1字节可能是分隔行的前缀，不能写；其余的攒够WRITE_SIZE后按页大小的整数倍写入
+ * 留在缓冲区中的数据已经查找过，下次从scanned_往前needle_.size() - 1字节处继续查找，不会重复扫描
+ */
+bool MultipartParser::parsePartData_(const char *&p, const char *end, bool last)
+{
+    size_t skip = scanned_ >= needle_.size() ? scanned_ - (needle_.size() - 1) : 0;
+    const char *delim = SimdScan::find(p + skip, end, needle_.data(), needle_.size());
+    if (delim != end)
+    {
+        writePart_(p, delim - p);
+        endPart_();
+        p = delim + needle_.size();
+        scanned_ = 0;
+        state_ = DELIMITER_TAIL;
+        return true;
+    }
+    if (last)
+    {
+        fail_("No Closing Boundary");
+        return true;
+    }
+    size_t avail = end - p;
+    size_t safe = avail >= needle_.size() ? avail - (needle_.size() - 1) : 0;
+    if (safe >= WRITE_SIZE)
+    {
+        size_t n = safe / PAGE_SIZE * PAGE_SIZE;
+        writePart_(p, n);
+        p += n;
+    }
+    scanned_ = end - p;
+    return false;
+}
+
+/*
+ * 部分头解析完成，带文件名的部分打开文件，普通表单字段忽略
+ * 只保留文件名中最后一个路径分隔符之后的部分，不允许以.开头（包括.和..），防止写到上传目录之外或者覆盖隐藏文件
+ */
+void MultipartParser::beginPart_()
+{
+    if (filename_.empty() || discard_)
+    {
+        return;
+    }
+    size_t slash = filename_.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? filename_ : filename_.substr(slash + 1);
+    bool valid = !name.empty() && name[0] != '.';
+    for (char ch : name)
+    {
+        if (static_cast<unsigned char>(ch) < 0x20 || ch == 0x7f)
+        {
+            valid = false;
+        }
+    }
+    if (!valid)
+    {
+        LOG_ERROR("Upload Filename Error! %s", filename_.c_str());
+        error_ = true;
+        return;
+    }
+    path_ = dir_ + name;
+    // 需要读权限：splice之后把文件映射到内存中查找分隔行
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        LOG_ERROR("Upload Open Error! %s, errno: %d", path_.c_str(), errno);
+        error_ = true;
+        return;
+    }
+    fileOff_ = 0;
+    LOG_DEBUG("Upload Begin! %s", path_.c_str());
+}
+
+/*
+ * 写入文件内容，处理部分写入和信号中断，写入失败时删除文件
+ */
+void MultipartParser::writePart_(const char *data, size_t len)
+{
+    while (fd_ >= 0 && len > 0)
+    {
+        ssize_t n = write(fd_, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("Upload Write Error! %s, errno: %d", path_.c_str(), errno);
+            error_ = true;
+            reset();
+            state_ = PART_DATA;
+            return;
+        }
+        data += n;
+        len -= n;
+        fileOff_ += n;
+    }
+}
+
+/*
+ * 部分结束，关闭文件
+ */
+void MultipartParser::endPart_()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    unmap_();
+    close(fd_);
+    fd_ = -1;
+    files_++;
+    LOG_DEBUG("Upload End! %s", path_.c_str());
+}
+
+/*
+ * 解除verify中文件的内存映射
+ */
+void MultipartParser::unmap_()
+{
+    if (map_ != nullptr)
+    {
+        munmap(map_, MAP_WINDOW);
+        map_ = nullptr;
+    }
+}
+
+/*
+ * 格式错误，删除没有上传完的文件，之后的数据全部忽略
+ */
+void MultipartParser::fail_(const char *reason)
+{
+    LOG_ERROR("Multipart Error! %s", reason);
+    error_ = true;
+    reset();
+}
@@ -0,0 +1,509 @@
+#include "../headers/router.h"
+#include "../headers/httprequest.h"
+
+/*
+ * 请求方法
+ */
+StringView RequestView::method() const
+{
+    return request_.method_;
+}
+
+/*
+ * 请求路径，不包括查询字符串
+ */
+StringView RequestView::path() const
+{
+    StringView path(request_.path_);
+    return path.substr(0, path.find("?"));
+}
+
+/*
+ * ?之后的查询字符串
+ */
+StringView RequestView::query() const
+{
+    StringView path(request_.path_);
+    size_t pos = path.find("?");
+    return pos == StringView::npos ? StringView() : path.substr(pos + 1);
+}
+
+/*
+ * 请求头字段
+ */
+StringView RequestView::header(const StringView &name) const
+{
+    return request_.header(name);
+}
+
+/*
+ * 路径参数
+ */
+StringView RequestView::param(const StringView &name) const
+{
+    const RouteMatch &match = request_.match_;
+    for (size_t i = 0; i < match.paramCnt; i++)
+    {
+        if (match.names[i] == name)
+        {
+            return match.values[i];
+        }
+    }
+    return StringView();
+}
+
+/*
+ * 请求体
+ */
+StringView RequestView::body() const
+{
+    return request_.body_;
+}
+
+/*
+ * 构造函数，响应从写缓冲区当前的末尾开始
+ */
+ResponseWriter::ResponseWriter(Buffer &buff, bool isKeepAlive, bool isHead)
+    : buff_(buff), isKeepAlive_(isKeepAlive), isHead_(isHead), code_(200), contentType_("text/plain"), headerCnt_(0),
+      headWritten_(false), lengthPos_(0), bodyPos_(0)
+{
+}
+
+/*
+ * 设置状态码，必须是三位数
+ */
+void ResponseWriter::setStatus(int code)
+{
+    assert(!headWritten_);
+    if (code < 100 || code > 999)
+    {
+        LOG_WARN("Response Status Error! %d", code);
+        code = 500;
+    }
+    code_ = code;
+}
+
+/*
+ * 设置Content-type
+ */
+void ResponseWriter::setContentType(const StringView &type)
+{
+    assert(!headWritten_);
+    contentType_ = type;
+}
+
+/*
+ * 添加响应头字段，超过上限的字段丢弃
+ */
+void ResponseWriter::addHeader(const StringView &name, const StringView &value)
+{
+    assert(!headWritten_);
+    if (headerCnt_ == MAX_HEADERS)
+    {
+        LOG_WARN("Too Many Response Headers! %.*s", (int)name.size(), name.data());
+        return;
+    }
+    names_[headerCnt_] = name;
+    values_[headerCnt_] = value;
+    headerCnt_++;
+}
+
+/*
+ * 写响应体
+ */
+void ResponseWriter::write(const StringView &data)
+{
+    Buffer &buff = body();
+    if (!data.empty())
+    {
+        buff.append(data.data(), data.size());
+    }
+}
+
+/*
+ * 按printf格式直接格式化到写缓冲区中，空间不够时扩容后再格式化一次
+ */
+void ResponseWriter::writef(const char *format, ...)
+{
+    Buffer &buff = body();
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buff.beginWrite(), buff.writableBytes(), format, args);
+    va_end(args);
+    if (n >= 0 && static_cast<size_t>(n) >= buff.writableBytes())
+    {
+        buff.ensureWritable(n + 1);
+        va_start(args, format);
+        n = vsnprintf(buff.beginWrite(), buff.writableBytes(), format, args);
+        va_end(args);
+    }
+    if (n > 0)
+    {
+        buff.hasWritten(n);
+    }
+}
+
+/*
+ * 响应体直接追加在写缓冲区中，第一次调用时生成响应头
+ */
+Buffer &ResponseWriter::body()
+{
+    if (!headWritten_)
+    {
+        writeHead_();
+    }
+    return buff_;
+}
+
+/*
+ * 完成响应，在预留的位置填入Content-length（右对齐，前面的空格是字段值之前允许的空白）
+ */
+void ResponseWriter::finish()
+{
+    if (!headWritten_)
+    {
+        writeHead_();
+    }
+    size_t len = buff_.readableBytes() - bodyPos_;
+    // 204和304不能有响应体，处理函数写了也丢弃，否则客户端会把它当作下一个响应
+    if (code_ == 204 || code_ == 304)
+    {
+        buff_.unwrite(len);
+        return;
+    }
+    char digits[LENGTH_WIDTH + 1];
+    int n = snprintf(digits, sizeof(digits), "%zu", len);
+    memcpy(buff_.beginRead() + lengthPos_ + LENGTH_WIDTH - n, digits, n);
+    // HEAD请求的响应和GET一样带Content-length，但是不能有响应体（RFC 7231 4.3.2）
+    if (isHead_)
+    {
+        buff_.unwrite(len);
+    }
+}
+
+/*
+ * 状态码
+ */
+int ResponseWriter::status() const
+{
+    return code_;
+}
+
+/*
+ * 生成状态行和响应头，Content-length的值先用空格占位
+ * note: 位置记录为相对可读数据开头的偏移，写响应体时缓冲区扩容或者搬移数据后仍然有效
+ */
+void ResponseWriter::writeHead_()
+{
+    static const char KEEP_ALIVE[] = "Connection: keep-alive\r\nkeep-alive: max=6, timeout=120\r\n";
+    static const char CLOSE[] = "Connection: close\r\n";
+    char line[64];
+    int n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\nContent-type: ", code_, reason_(code_));
+    buff_.append(line, n);
+    if (!contentType_.empty())
+    {
+        buff_.append(contentType_.data(), contentType_.size());
+    }
+    buff_.append("\r\n", 2);
+    if (isKeepAlive_)
+    {
+        buff_.append(KEEP_ALIVE, sizeof(KEEP_ALIVE) - 1);
+    }
+    else
+    {
+        buff_.append(CLOSE, sizeof(CLOSE) - 1);
+    }
+    for (size_t i = 0; i < headerCnt_; i++)
+    {
+        buff_.append(names_[i].data(), names_[i].size());
+        buff_.append(": ", 2);
+        if (!values_[i].empty())
+        {
+            buff_.append(values_[i].data(), values_[i].size());
+        }
+        buff_.append("\r\n", 2);
+    }
+    // 204和304没有响应体，不发送Content-length
+    if (code_ != 204 && code_ != 304)
+    {
+        buff_.append("Content-length:", 15);
+        lengthPos_ = buff_.readableBytes();
+        buff_.ensureWritable(LENGTH_WIDTH);
+        memset(buff_.beginWrite(), ' ', LENGTH_WIDTH);
+        buff_.hasWritten(LENGTH_WIDTH);
+        buff_.append("\r\n", 2);
+    }
+    buff_.append("\r\n", 2);
+    bodyPos_ = buff_.readableBytes();
+    headWritten_ = true;
+}
+
+/*
+ * 状态码的说明
+ */
+const char *ResponseWriter::reason_(int code)
+{
+    switch (code)
+    {
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 202:
+        return "Accepted";
+    case 204:
+        return "No Content";
+    case 301:
+        return "Moved Permanently";
+    case 302:
+        return "Found";
+    case 304:
+        return "Not Modified";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 403:
+        return "Forbidden";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 409:
+        return "Conflict";
+    case 413:
+        return "Payload Too Large";
+    case 415:
+        return "Unsupported Media Type";
+    case 422:
+        return "Unprocessable Entity";
+    case 429:
+        return "Too Many Requests";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return "Unknown";
+    }
+}
+
+/*
+ * 单例模式，局部静态变量，C++11之后线程安全
+ */
+Router *Router::instance()
+{
+    static Router router;
+    return &router;
+}
+
+/*
+ * 注册路由
+ * 模式按静态片段、:name、*name依次插入基数树，同一位置的参数名必须相同，同一个方法和模式只能注册一次
+ */
+bool Router::add(const char *method, const char *pattern, RouteHandler handler)
+{
+    int index = methodIndex_(method);
+    if (index < 0 || !pattern || pattern[0] != '/' || !handler)
+    {
+        LOG_ERROR("Route Error! %s %s", method, pattern ? pattern : "");
+        return false;
+    }
+    Node *node = root_.get();
+    const char *p = pattern;
+    const char *end = pattern + strlen(pattern);
+    size_t params = 0;
+    while (p < end)
+    {
+        if (*p != ':' && *p != '*')
+        {
+            const char *q = p;
+            while (q < end && *q != ':' && *q != '*')
+            {
+                q++;
+            }
+            node = insertStatic_(node, p, q);
+            p = q;
+            continue;
+        }
+        // 参数只能是完整的一段：前面是/，:name到下一个/为止，*name到结尾为止
+        bool isParam = (*p == ':');
+        const char *name = ++p;
+        while (p < end && *p != '/')
+        {
+            p++;
+        }
+        if (name[-2] != '/' || p == name || (!isParam && p != end) || params == RouteMatch::MAX_PARAMS)
+        {
+            LOG_ERROR("Route Pattern Error! %s %s", method, pattern);
+            return false;
+        }
+        std::unique_ptr<Node> &child = isParam ? node->param : node->wildcard;
+        if (!child)
+        {
+            child.reset(new Node);
+            child->prefix.assign(name, p);
+        }
+        else if (StringView(child->prefix) != StringView(name, p - name))
+        {
+            LOG_ERROR("Route Param Conflict! %s %s", method, pattern);
+            return false;
+        }
+        node = child.get();
+        params++;
+    }
+    if (node->handlers[index])
+    {
+        LOG_ERROR("Route Duplicated! %s %s", method, pattern);
+        return false;
+    }
+    node->handlers[index] = handler;
+    count_++;
+    return true;
+}
+
+/*
+ * 查找路由，查询字符串不参与匹配
+ */
+bool Router::match(const StringView &method, const StringView &path, RouteMatch &match) const
+{
+    match.handler = nullptr;
+    match.paramCnt = 0;
+    if (count_ == 0)
+    {
+        return false;
+    }
+    int index = methodIndex_(method);
+    if (index < 0)
+    {
+        return false;
+    }
+    const char *end = static_cast<const char *>(memchr(path.data(), '?', path.size()));
+    return match_(root_.get(), path.data(), end ? end : path.end(), index, match);
+}
+
+/*
+ * 是否注册了路由
+ */
+bool Router::empty() const
+{
+    return count_ == 0;
+}
+
+/*
+ * 方法名对应的METHOD
+ */
+int Router::methodIndex_(const StringView &method)
+{
+    static const char *NAMES[METHOD_COUNT] = {"GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS"};
+    for (int i = 0; i < METHOD_COUNT; i++)
+    {
+        if (method == NAMES[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * 插入静态片段：沿着首字符相同的子节点向下走，片段只有一部分相同时拆分子节点
+ */
+Router::Node *Router::insertStatic_(Node *node, const char *p, const char *end)
+{
+    while (p < end)
+    {
+        std::unique_ptr<Node> *next = nullptr;
+        for (auto &child : node->children)
+        {
+            if (child->prefix[0] == *p)
+            {
+                next = &child;
+                break;
+            }
+        }
+        // 没有首字符相同的子节点，剩下的片段作为新的子节点
+        if (!next)
+        {
+            node->children.emplace_back(new Node);
+            node->children.back()->prefix.assign(p, end);
+            return node->children.back().get();
+        }
+        // 公共前缀的长度
+        const std::string &prefix = (*next)->prefix;
+        size_t n = 0;
+        while (n < prefix.size() && p + n < end && prefix[n] == p[n])
+        {
+            n++;
+        }
+        // 子节点的片段比公共前缀长：公共前缀作为新的子节点，原来的子节点去掉公共前缀后挂在它下面
+        if (n < prefix.size())
+        {
+            std::unique_ptr<Node> split(new Node);
+            split->prefix.assign(prefix, 0, n);
+            (*next)->prefix.erase(0, n);
+            split->children.push_back(std::move(*next));
+            *next = std::move(split);
+        }
+        node = next->get();
+        p += n;
+    }
+    return node;
+}
+
+/*
+ * 匹配：静态子节点（首字符相同的最多一个）优先，其次:name，最后*name，子树匹配失败时回溯
+ */
+bool Router::match_(const Node *node, const char *p, const char *end, int method, RouteMatch &match)
+{
+    if (p == end && node->handlers[method])
+    {
+        match.handler = node->handlers[method];
+        return true;
+    }
+    if (p < end)
+    {
+        for (const auto &child : node->children)
+        {
+            const std::string &prefix = child->prefix;
+            if (prefix[0] != *p)
+            {
+                continue;
+            }
+            if (static_cast<size_t>(end - p) >= prefix.size() && memcmp(p, prefix.data(), prefix.size()) == 0 &&
+                match_(child.get(), p + prefix.size(), end, method, match))
+            {
+                return true;
+            }
+            break;
+        }
+        if (node->param && match.paramCnt < RouteMatch::MAX_PARAMS)
+        {
+            const char *q = static_cast<const char *>(memchr(p, '/', end - p));
+            q = q ? q : end;
+            if (q != p)
+            {
+                size_t i = match.paramCnt++;
+                match.names[i] = node->param->prefix;
+                match.values[i] = StringView(p, q - p);
+                if (match_(node->param.get(), q, end, method, match))
+                {
+                    return true;
+                }
+                match.paramCnt--;
+            }
+        }
+    }
+    // *name匹配剩下的全部，可以为空
+    if (node->wildcard && node->wildcard->handlers[method] && match.paramCnt < RouteMatch::MAX_PARAMS)
+    {
+        size_t i = match.paramCnt++;
+        match.names[i] = node->wildcard->prefix;
+        match.values[i] = StringView(p, end - p);
+        match.handler = node->wildcard->handlers[method];
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+#include "../headers/routetable.h"
+
+#define ROUTE(path, target, handler) {path, sizeof(path) - 1, target, handler}
+
+/*
+ * 注册的路由，新增页面别名或者处理函数只需要在这里加一行
+ * 带.html后缀的登录和注册页面也要注册处理函数：表单提交到/login.html和/login是一样的
+ */
+constexpr RouteTable::Route RouteTable::ROUTES[] = {
+    ROUTE("/", "/index.html", NONE),
+    ROUTE("/index", "/index.html", NONE),
+    ROUTE("/register", "/register.html", REGISTER),
+    ROUTE("/register.html", nullptr, REGISTER),
+    ROUTE("/login", "/login.html", LOGIN),
+    ROUTE("/login.html", nullptr, LOGIN),
+    ROUTE("/welcome", "/welcome.html", NONE),
+    ROUTE("/video", "/video.html", NONE),
+    ROUTE("/picture", "/picture.html", NONE),
+    ROUTE("/upload", "/upload.html", NONE),
+    ROUTE("/success", "/success.html", NONE)};
+
+constexpr size_t RouteTable::ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+
+/*
+ * 按种子把路由放入槽中，两个路由落在同一个槽时返回false
+ */
+constexpr bool RouteTable::fill_(uint32_t seed, Slots &slots)
+{
+    static_assert(ROUTE_COUNT * 2 <= SLOT_COUNT, "too many routes, increase SLOT_COUNT");
+    for (size_t i = 0; i < SLOT_COUNT; i++)
+    {
+        slots.index[i] = EMPTY;
+    }
+    for (size_t i = 0; i < ROUTE_COUNT; i++)
+    {
+        uint8_t &slot = slots.index[hash(ROUTES[i].path, ROUTES[i].len, seed) & (SLOT_COUNT - 1)];
+        if (slot != EMPTY)
+        {
+            return false;
+        }
+        slot = static_cast<uint8_t>(i);
+    }
+    return true;
+}
+
+/*
+ * 从0开始逐个尝试种子，直到所有路由都落在不同的槽中
+ * 路由数不超过槽数的一半时很快就能找到；一直找不到时编译期求值超过步数限制，编译失败
+ */
+constexpr uint32_t RouteTable::findSeed_()
+{
+    for (uint32_t seed = 0;; seed++)
+    {
+        Slots slots{};
+        if (fill_(seed, slots))
+        {
+            return seed;
+        }
+    }
+}
+
+/*
+ * 按找到的种子生成槽
+ */
+constexpr RouteTable::Slots RouteTable::buildSlots_()
+{
+    Slots slots{};
+    fill_(SEED, slots);
+    return slots;
+}
+
+constexpr uint32_t RouteTable::SEED = findSeed_();
+constexpr RouteTable::Slots RouteTable::SLOTS = buildSlots_();
@@ -0,0 +1,438 @@
+#include "../headers/simdscan.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86
+#endif
+
+/*
+ * token字符表以及按半字节拆分的查找表
+ * token字符都是ASCII，字符c是token当且仅当 LO[c & 0xf] & HI[c >> 4] 不为0：
+ * LO[l]的第h位表示字符(h << 4 | l)是否是token，HI[h]为1 << h（h >= 8时为0，非ASCII字符都不是token）
+ * 这样SIMD实现用两次字节重排（pshufb）就能判断16/32个字符是否是token
+ */
+struct TokenTable
+{
+    bool token[256];
+    alignas(16) unsigned char lo[16];
+    alignas(16) unsigned char hi[16];
+
+    TokenTable()
+    {
+        const char *separators = "()<>@,;:\\\"/[]?={}";
+        for (int c = 0; c < 256; c++)
+        {
+            token[c] = c > 0x20 && c < 0x7f && !strchr(separators, c);
+        }
+        for (int l = 0; l < 16; l++)
+        {
+            lo[l] = 0;
+            for (int h = 0; h < 8; h++)
+            {
+                if (token[h << 4 | l])
+                {
+                    lo[l] |= 1 << h;
+                }
+            }
+            hi[l] = l < 8 ? 1 << l : 0;
+        }
+    }
+};
+
+static const TokenTable TOKEN_TABLE;
+
+/*
+ * 是否是token字符
+ */
+bool SimdScan::isToken(char ch)
+{
+    return TOKEN_TABLE.token[static_cast<unsigned char>(ch)];
+}
+
+/*
+ * 标量实现
+ */
+static const char *findCRLFScalar(const char *begin, const char *end)
+{
+    for (const char *p = begin; p + 1 < end; p++)
+    {
+        if (p[0] == '\r' && p[1] == '\n')
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+static const char *findNonTokenScalar(const char *begin, const char *end)
+{
+    const char *p = begin;
+    while (p < end && TOKEN_TABLE.token[static_cast<unsigned char>(*p)])
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char *findSpaceOrCtlScalar(const char *begin, const char *end)
+{
+    const char *p = begin;
+    while (p < end && static_cast<unsigned char>(*p) > 0x20 && *p != 0x7f)
+    {
+        p++;
+    }
+    return p;
+}
+
+/*
+ * 逐个用memchr找needle的首字节，再比较整个needle
+ */
+static const char *findScalar(const char *begin, const char *end, const char *needle, size_t len)
+{
+    if (len == 0)
+    {
+        return begin;
+    }
+    if (static_cast<size_t>(end - begin) < len)
+    {
+        return end;
+    }
+    // 最后一个可能的起始位置
+    const char *last = end - len;
+    const char *p = begin;
+    while (p <= last)
+    {
+        p = static_cast<const char *>(memchr(p, needle[0], last - p + 1));
+        if (!p)
+        {
+            return end;
+        }
+        if (memcmp(p + 1, needle + 1, len - 1) == 0)
+        {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+#ifdef SIMD_SCAN_X86
+
+/*
+ * 在mask标记的所有\r中查找后面紧跟\n的第一个，p为mask第0位对应的位置
+ */
+static const char *matchCRLF(const char *p, const char *end, unsigned mask)
+{
+    while (mask)
+    {
+        const char *cr = p + __builtin_ctz(mask);
+        if (cr + 1 < end && cr[1] == '\n')
+        {
+            return cr;
+        }
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
+/*
+ * 16字节块的内核，返回块中满足条件的字节的位掩码
+ * note: 强制内联，在AVX2函数中按VEX编码生成；如果AVX2函数直接调用SSE函数（GCC会生成不带vzeroupper的尾调用），
+ * 传统SSE指令会在YMM高位脏的状态下执行，触发SSE/AVX切换惩罚，实测解析速度反而下降一半以上
+ */
+__attribute__((always_inline, target("sse4.2"))) static inline unsigned crMask16(const char *p)
+{
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+}
+
+__attribute__((always_inline, target("sse4.2"))) static inline unsigned nonTokenMask16(const char *p)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i l = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_TABLE.lo)), _mm_and_si128(v, nibble));
+    __m128i h = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_TABLE.hi)),
+                                 _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(l, h), _mm_setzero_si128()));
+}
+
+__attribute__((always_inline, target("sse4.2"))) static inline unsigned spaceOrCtlMask16(const char *p)
+{
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // 无符号比较v <= 0x20
+    __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x20)), v);
+    return _mm_movemask_epi8(_mm_or_si128(ctl, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+}
+
+/*
+ * 32字节块的内核
+ */
+__attribute__((always_inline, target("avx2"))) static inline unsigned crMask32(const char *p)
+{
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+}
+
+__attribute__((always_inline, target("avx2"))) static inline unsigned nonTokenMask32(const char *p)
+{
+    // 查找表复制到高低两个128位通道，vpshufb在每个通道内独立查表
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_TABLE.lo)));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_TABLE.hi)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble));
+    __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(l, h), _mm256_setzero_si256()));
+}
+
+__attribute__((always_inline, target("avx2"))) static inline unsigned spaceOrCtlMask32(const char *p)
+{
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x20)), v);
+    return _mm256_movemask_epi8(_mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f))));
+}
+
+/*
+ * 在mask标记的所有候选起始位置中查找完整匹配needle的第一个，p为mask第0位对应的位置
+ */
+static const char *matchNeedle(const char *p, unsigned mask, const char *needle, size_t len)
+{
+    while (mask)
+    {
+        const char *candidate = p + __builtin_ctz(mask);
+        if (memcmp(candidate + 1, needle + 1, len - 2) == 0)
+        {
+            return candidate;
+        }
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
+/*
+ * 子串查找的16/32字节块内核：同时比较每个位置上needle的首字节和末字节（参考Wojciech Mula的SIMD子串查找），
+ * 两者都相等的位置才需要memcmp确认，对二进制数据误判的概率约为1/65536
+ */
+__attribute__((always_inline, target("sse4.2"))) static inline unsigned needleMask16(const char *p, const char *needle, size_t len)
+{
+    __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi8(needle[0]));
+    __m128i last = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + len - 1)), _mm_set1_epi8(needle[len - 1]));
+    return _mm_movemask_epi8(_mm_and_si128(first, last));
+}
+
+__attribute__((always_inline, target("avx2"))) static inline unsigned needleMask32(const char *p, const char *needle, size_t len)
+{
+    __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi8(needle[0]));
+    __m256i last = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + len - 1)), _mm256_set1_epi8(needle[len - 1]));
+    return _mm256_movemask_epi8(_mm256_and_si256(first, last));
+}
+
+/*
+ * SSE4.2实现，每次处理16字节，剩余不足16字节的部分用标量实现
+ * matchCRLF会检查块外的下一个字节，块末尾的\r不会漏掉
+ */
+__attribute__((target("sse4.2"))) static const char *findCRLFSse(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 16; p += 16)
+    {
+        const char *found = matchCRLF(p, end, crMask16(p));
+        if (found)
+        {
+            return found;
+        }
+    }
+    return findCRLFScalar(p, end);
+}
+
+__attribute__((target("sse4.2"))) static const char *findNonTokenSse(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 16; p += 16)
+    {
+        unsigned mask = nonTokenMask16(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findNonTokenScalar(p, end);
+}
+
+__attribute__((target("sse4.2"))) static const char *findSpaceOrCtlSse(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 16; p += 16)
+    {
+        unsigned mask = spaceOrCtlMask16(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findSpaceOrCtlScalar(p, end);
+}
+
+__attribute__((target("sse4.2"))) static const char *findSse(const char *begin, const char *end, const char *needle, size_t len)
+{
+    // needle太短时首末字节比较没有意义，交给标量实现
+    if (len < 2 || static_cast<size_t>(end - begin) < len)
+    {
+        return findScalar(begin, end, needle, len);
+    }
+    // 块内的每个起始位置都要能放下整个needle
+    const char *p = begin;
+    for (; static_cast<size_t>(end - p) >= 16 + len - 1; p += 16)
+    {
+        const char *found = matchNeedle(p, needleMask16(p, needle, len), needle, len);
+        if (found)
+        {
+            return found;
+        }
+    }
+    return findScalar(p, end, needle, len);
+}
+
+/*
+ * AVX2实现，每次处理32字节，剩余部分先处理一个16字节块，再用标量实现
+ */
+__attribute__((target("avx2"))) static const char *findCRLFAvx2(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 32; p += 32)
+    {
+        const char *found = matchCRLF(p, end, crMask32(p));
+        if (found)
+        {
+            return found;
+        }
+    }
+    if (end - p >= 16)
+    {
+        const char *found = matchCRLF(p, end, crMask16(p));
+        if (found)
+        {
+            return found;
+        }
+        p += 16;
+    }
+    return findCRLFScalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *findNonTokenAvx2(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 32; p += 32)
+    {
+        unsigned mask = nonTokenMask32(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    if (end - p >= 16)
+    {
+        unsigned mask = nonTokenMask16(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findNonTokenScalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *findSpaceOrCtlAvx2(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 32; p += 32)
+    {
+        unsigned mask = spaceOrCtlMask32(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    if (end - p >= 16)
+    {
+        unsigned mask = spaceOrCtlMask16(p);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findSpaceOrCtlScalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *findAvx2(const char *begin, const char *end, const char *needle, size_t len)
+{
+    if (len < 2 || static_cast<size_t>(end - begin) < len)
+    {
+        return findScalar(begin, end, needle, len);
+    }
+    const char *p = begin;
+    for (; static_cast<size_t>(end - p) >= 32 + len - 1; p += 32)
+    {
+        const char *found = matchNeedle(p, needleMask32(p, needle, len), needle, len);
+        if (found)
+        {
+            return found;
+        }
+    }
+    if (static_cast<size_t>(end - p) >= 16 + len - 1)
+    {
+        const char *found = matchNeedle(p, needleMask16(p, needle, len), needle, len);
+        if (found)
+        {
+            return found;
+        }
+        p += 16;
+    }
+    return findScalar(p, end, needle, len);
+}
+
+#endif // SIMD_SCAN_X86
+
+/*
+ * 通过CPUID选择的实现编号：2为AVX2，1为SSE4.2，0为标量
+ */
+static int detectIsa()
+{
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return 2;
+    }
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+static const int ISA = detectIsa();
+
+#ifdef SIMD_SCAN_X86
+SimdScan::ScanFunc SimdScan::findCRLF_ = ISA == 2 ? findCRLFAvx2 : (ISA == 1 ? findCRLFSse : findCRLFScalar);
+SimdScan::ScanFunc SimdScan::findNonToken_ = ISA == 2 ? findNonTokenAvx2 : (ISA == 1 ? findNonTokenSse : findNonTokenScalar);
+SimdScan::ScanFunc SimdScan::findSpaceOrCtl_ = ISA == 2 ? findSpaceOrCtlAvx2 : (ISA == 1 ? findSpaceOrCtlSse : findSpaceOrCtlScalar);
+SimdScan::FindFunc SimdScan::find_ = ISA == 2 ? findAvx2 : (ISA == 1 ? findSse : findScalar);
+#else
+SimdScan::ScanFunc SimdScan::findCRLF_ = findCRLFScalar;
+SimdScan::ScanFunc SimdScan::findNonToken_ = findNonTokenScalar;
+SimdScan::ScanFunc SimdScan::findSpaceOrCtl_ = findSpaceOrCtlScalar;
+SimdScan::FindFunc SimdScan::find_ = findScalar;
+#endif
+
+/*
+ * 当前使用的实现
+ */
+const char *SimdScan::isa()
+{
+    return ISA == 2 ? "AVX2" : (ISA == 1 ? "SSE4.2" : "Scalar");
+}
@@ -0,0 +1,294 @@
+#include "../headers/timewheel.h"
+
+/*
+ * 构造函数，以当前时间作为第0个tick
+ */
+TimeWheel::TimeWheel() : start_(Clock::now()), current_(0), count_(0), slots_(SLOT_NUM, -1)
+{
+    nodes_.reserve(1024);
+    for (int i = 0; i < SLOT_NUM / 64; i++)
+    {
+        bitmap_[i] = 0;
+    }
+}
+
+/*
+ * 析构函数，清空所有定时器
+ */
+TimeWheel::~TimeWheel()
+{
+    clear();
+}
+
+/*
+ * 当前时间对应的tick，1tick为1ms
+ */
+uint64_t TimeWheel::now_() const
+{
+    return std::chrono::duration_cast<MS>(Clock::now() - start_).count();
+}
+
+/*
+ * 第level层第index个槽的全局编号
+ */
+int TimeWheel::slotOf_(int level, int index)
+{
+    return level == 0 ? index : ROOT_SIZE + (level - 1) * LEVEL_SIZE + index;
+}
+
+/*
+ * 返回fd对应的节点，数组不够大时扩容
+ */
+TimeWheel::WheelNode &TimeWheel::node_(int id)
+{
+    assert(id >= 0);
+    if (static_cast<size_t>(id) >= nodes_.size())
+    {
+        nodes_.resize(id + 1, {0, -1, -1, -1, TimeoutCallBack()});
+    }
+    return nodes_[id];
+}
+
+/*
+ * 根据超时时间把节点挂到对应的槽上
+ * 与当前tick的差值决定所在的层：差值越大层越高，高层的槽在级联时再逐步下放
+ */
+void TimeWheel::link_(int id)
+{
+    WheelNode &node = nodes_[id];
+    assert(node.slot == -1);
+    uint64_t expires = node.expires;
+    int slot;
+    // 已经超时的节点放到当前槽，本轮推进时立即处理
+    if (expires < current_)
+    {
+        slot = slotOf_(0, current_ & (ROOT_SIZE - 1));
+    }
+    else
+    {
+        uint64_t delta = expires - current_;
+        // 超出时间轮范围的节点先放在最高层，级联时会重新计算
+        if (delta >= MAX_TICKS)
+        {
+            expires = current_ + MAX_TICKS - 1;
+            delta = MAX_TICKS - 1;
+        }
+        if (delta < (1ull << ROOT_BITS))
+        {
+            slot = slotOf_(0, expires & (ROOT_SIZE - 1));
+        }
+        else
+        {
+            int level = 1;
+            while (level < LEVELS - 1 && delta >= (1ull << (ROOT_BITS + level * LEVEL_BITS)))
+            {
+                level++;
+            }
+            int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+            slot = slotOf_(level, (expires >> shift) & (LEVEL_SIZE - 1));
+        }
+    }
+    // 头插法挂到槽的链表上
+    node.slot = slot;
+    node.prev = -1;
+    node.next = slots_[slot];
+    if (node.next != -1)
+    {
+        nodes_[node.next].prev = id;
+    }
+    slots_[slot] = id;
+    bitmap_[slot >> 6] |= 1ull << (slot & 63);
+    count_++;
+}
+
+/*
+ * 把节点从所在槽上摘下
+ */
+void TimeWheel::unlink_(int id)
+{
+    WheelNode &node = nodes_[id];
+    assert(node.slot != -1);
+    if (node.prev != -1)
+    {
+        nodes_[node.prev].next = node.next;
+    }
+    else
+    {
+        slots_[node.slot] = node.next;
+    }
+    if (node.next != -1)
+    {
+        nodes_[node.next].prev = node.prev;
+    }
+    // 槽变为空时清除位图
+    if (slots_[node.slot] == -1)
+    {
+        bitmap_[node.slot >> 6] &= ~(1ull << (node.slot & 63));
+    }
+    node.slot = node.prev = node.next = -1;
+    count_--;
+}
+
+/*
+ * 把第level层第index个槽中的节点重新插入，它们离超时已经不到一圈，会落到更低的层
+ */
+void TimeWheel::cascade_(int level, int index)
+{
+    int slot = slotOf_(level, index);
+    while (slots_[slot] != -1)
+    {
+        int id = slots_[slot];
+        unlink_(id);
+        link_(id);
+    }
+}
+
+/*
+ * 第0层中从from开始的第一个非空槽，没有时返回ROOT_SIZE（即下一次级联的位置）
+ */
+int TimeWheel::findSlot_(int from) const
+{
+    for (int i = from; i < ROOT_SIZE; i = (i & ~63) + 64)
+    {
+        uint64_t word = bitmap_[i >> 6] & (~0ull << (i & 63));
+        if (word)
+        {
+            return (i & ~63) + __builtin_ctzll(word);
+        }
+    }
+    return ROOT_SIZE;
+}
+
+/*
+ * 将指定文件描述符id添加一个定时器，超时时间为timeout，回调函数为cb
+ * 已有节点时更新超时时间和回调函数
+ */
+void TimeWheel::add(int id, int timeout, const TimeoutCallBack &cb)
+{
+    WheelNode &node = node_(id);
+    if (node.slot != -1)
+    {
+        unlink_(id);
+    }
+    node.expires = now_() + timeout;
+    node.cb = cb;
+    link_(id);
+}
+
+/*
+ * 调整文件描述符id关联的定时器的过期时间为：当前时间+timeout，只需要摘下再挂上，O(1)
+ */
+void TimeWheel::adjust(int id, int timeout)
+{
+    // 定时器可能已经触发（连接正在等待关闭），此时忽略
+    if (id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == -1)
+    {
+        return;
+    }
+    unlink_(id);
+    nodes_[id].expires = now_() + timeout;
+    link_(id);
+}
+
+/*
+ * 删除指定id结点，并触发回调函数
+ */
+void TimeWheel::doWork(int id)
+{
+    if (id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == -1)
+    {
+        return;
+    }
+    unlink_(id);
+    // 回调函数中可能添加新的定时器导致nodes_扩容，所以先拷贝出回调函数
+    TimeoutCallBack cb = nodes_[id].cb;
+    cb();
+}
+
+/*
+ * 删除指定id结点，不触发回调函数（连接关闭时调用，fd可能被其他Reactor复用）
+ */
+void TimeWheel::cancel(int id)
+{
+    if (id < 0 || static_cast<size_t>(id) >= nodes_.size() || nodes_[id].slot == -1)
+    {
+        return;
+    }
+    unlink_(id);
+}
+
+/*
+ * 清空所有定时器
+ */
+void TimeWheel::clear()
+{
+    nodes_.clear();
+    std::fill(slots_.begin(), slots_.end(), -1);
+    for (int i = 0; i < SLOT_NUM / 64; i++)
+    {
+        bitmap_[i] = 0;
+    }
+    count_ = 0;
+}
+
+/*
+ * 推进时间轮到当前时间，删除所有超时节点，并触发它们的回调函数
+ * 每次推进到下一个非空槽或者下一次级联的位置，空槽直接跳过
+ */
+void TimeWheel::tick()
+{
+    uint64_t now = now_();
+    while (current_ <= now)
+    {
+        // 时间轮中没有节点，直接推进到当前时间
+        if (count_ == 0)
+        {
+            current_ = now + 1;
+            break;
+        }
+        int index = current_ & (ROOT_SIZE - 1);
+        // 第0层转满一圈，级联上层对应的槽，上层也转满一圈时继续级联更上一层
+        if (index == 0)
+        {
+            for (int level = 1; level < LEVELS; level++)
+            {
+                int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+                int levelIndex = (current_ >> shift) & (LEVEL_SIZE - 1);
+                cascade_(level, levelIndex);
+                if (levelIndex != 0)
+                {
+                    break;
+                }
+            }
+        }
+        // 触发当前槽中的所有节点，回调函数中新加入的已超时节点也会放到当前槽，一并处理
+        while (slots_[index] != -1)
+        {
+            int id = slots_[index];
+            unlink_(id);
+            TimeoutCallBack cb = nodes_[id].cb;
+            cb();
+        }
+        // 下一个要处理的tick：第0层本圈中下一个非空槽，没有的话就是下一次级联的位置
+        uint64_t next = current_ - index + findSlot_(index + 1);
+        current_ = std::min(next, now + 1);
+    }
+}
+
+/*
+ * 删除所有超时节点，返回最近一个超时节点的超时时间，没有定时器时返回-1
+ * 最近的节点不在第0层本圈中时，返回到下一次级联的时间，级联之后再重新计算
+ */
+int TimeWheel::getNextTick()
+{
+    tick();
+    if (count_ == 0)
+    {
+        return -1;
+    }
+    int index = current_ & (ROOT_SIZE - 1);
+    // 当前tick是一圈的开始时，上层的级联还没有进行，第0层本圈的节点还不完整，需要在当前tick醒来
+    uint64_t next = index == 0 ? current_ : current_ - index + findSlot_(index);
+    uint64_t now = now_();
+    return next > now ? static_cast<int>(next - now) : 0;
+}
@@ -0,0 +1,422 @@
+#include "../headers/uringpoller.h"
+
+/*
+ * 构造函数，创建io_uring实例
+ * 要求SQPOLL时先尝试开启，失败（比如权限不足）则使用普通模式，都失败时isOpen()返回false
+ * note: SQPOLL的内核线程空闲前一直占用一个CPU，只在明确要求时开启
+ */
+UringPoller::UringPoller(unsigned entries, bool sqpoll) : ringFd_(-1), sqpoll_(false), sqes_(nullptr), sqPtr_(MAP_FAILED),
+                                                          cqPtr_(MAP_FAILED), toSubmit_(0), waiting_(false)
+{
+    assert(entries > 0);
+    if (!(sqpoll && setup_(entries, true)))
+    {
+        setup_(entries, false);
+    }
+}
+
+/*
+ * 析构函数，解除映射并关闭io_uring实例
+ */
+UringPoller::~UringPoller()
+{
+    if (sqes_)
+    {
+        munmap(sqes_, sqesSize_);
+    }
+    if (cqPtr_ != MAP_FAILED && cqPtr_ != sqPtr_)
+    {
+        munmap(cqPtr_, cqSize_);
+    }
+    if (sqPtr_ != MAP_FAILED)
+    {
+        munmap(sqPtr_, sqSize_);
+    }
+    if (ringFd_ >= 0)
+    {
+        close(ringFd_);
+    }
+}
+
+/*
+ * 创建io_uring实例并映射提交队列、完成队列和SQE数组
+ */
+bool UringPoller::setup_(unsigned entries, bool sqpoll)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (sqpoll)
+    {
+        // 内核线程空闲100ms后休眠，休眠后需要IORING_ENTER_SQ_WAKEUP唤醒
+        params.flags = IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = 100;
+    }
+    int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    // wait需要IORING_ENTER_EXT_ARG传递超时时间（5.11+）
+    if (!(params.features & IORING_FEAT_EXT_ARG))
+    {
+        close(fd);
+        return false;
+    }
+
+    sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+    }
+    void *sqPtr = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqPtr == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    void *cqPtr = sqPtr;
+    if (!singleMmap)
+    {
+        cqPtr = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED)
+        {
+            munmap(sqPtr, sqSize_);
+            close(fd);
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        if (cqPtr != sqPtr)
+        {
+            munmap(cqPtr, cqSize_);
+        }
+        munmap(sqPtr, sqSize_);
+        close(fd);
+        return false;
+    }
+
+    ringFd_ = fd;
+    sqpoll_ = sqpoll;
+    sqPtr_ = sqPtr;
+    cqPtr_ = cqPtr;
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+    // 根据内核返回的偏移量定位队列中的各个字段
+    char *sq = static_cast<char *>(sqPtr);
+    sqHead_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqEntries_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    sqFlags_ = reinterpret_cast<unsigned *>(sq + params.sq_off.flags);
+    sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqLocalTail_ = *sqTail_;
+    char *cq = static_cast<char *>(cqPtr);
+    cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+}
+
+/*
+ * 返回io_uring是否创建成功
+ */
+bool UringPoller::isOpen() const
+{
+    return ringFd_ >= 0;
+}
+
+/*
+ * 返回是否开启了SQPOLL
+ */
+bool UringPoller::isSqpoll() const
+{
+    return sqpoll_;
+}
+
+/*
+ * io_uring_enter系统调用封装
+ */
+int UringPoller::enter_(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize)
+{
+    return syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, arg, argSize);
+}
+
+/*
+ * 返回fd对应的注册信息，不够时扩容
+ */
+UringPoller::FdState &UringPoller::state_(int fd)
+{
+    assert(fd >= 0);
+    if (static_cast<size_t>(fd) >= fdStates_.size())
+    {
+        fdStates_.resize(std::max(static_cast<size_t>(fd) + 1, fdStates_.size() * 2), FdState{0, 0, false});
+    }
+    return fdStates_[fd];
+}
+
+/*
+ * 获取一个空闲的SQE，提交队列满时先让内核取走已发布的请求
+ */
+struct io_uring_sqe *UringPoller::getSqe_()
+{
+    while (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= *sqEntries_)
+    {
+        if (sqpoll_)
+        {
+            // 唤醒可能在休眠的内核线程，等待它消费提交队列
+            enter_(0, 0, IORING_ENTER_SQ_WAKEUP, nullptr, 0);
+            sched_yield();
+        }
+        else
+        {
+            enter_(toSubmit_, 0, 0, nullptr, 0);
+            toSubmit_ = 0;
+        }
+    }
+    struct io_uring_sqe *sqe = &sqes_[sqLocalTail_ & *sqMask_];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/*
+ * 发布SQE，release保证内核看到新的tail时SQE内容已经写入
+ */
+void UringPoller::pushSqe_()
+{
+    unsigned index = sqLocalTail_ & *sqMask_;
+    sqArray_[index] = index;
+    sqLocalTail_++;
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    toSubmit_++;
+}
+
+/*
+ * 写入一个POLL_ADD请求
+ * ET且不带EPOLLONESHOT的事件使用multishot poll，每次唤醒产生一个完成事件
+ * 其余使用单次poll：EPOLLONESHOT触发后由modFd重新注册；LT事件在收割时自动重新注册，
+ * 单次poll在描述符仍然就绪时会立即完成，从而模拟水平触发（multishot只在新的唤醒时触发，不能用于LT）
+ * user_data高32位为注册代数，低32位为fd
+ */
+bool UringPoller::pollAdd_(int fd)
+{
+    FdState &st = state_(fd);
+    bool multishot = (st.events & EPOLLET) && !(st.events & EPOLLONESHOT);
+    struct io_uring_sqe *sqe = getSqe_();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    // 单次poll不需要EPOLLET，multishot保留EPOLLET语义
+    sqe->poll32_events = st.events & ~(EPOLLONESHOT | (multishot ? 0 : EPOLLET));
+    sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = (static_cast<uint64_t>(st.gen) << 32) | static_cast<uint32_t>(fd);
+    pushSqe_();
+    st.armed = true;
+    return true;
+}
+
+/*
+ * 写入一个POLL_REMOVE请求，删除fd当前代数的poll
+ */
+void UringPoller::pollRemove_(int fd)
+{
+    FdState &st = state_(fd);
+    struct io_uring_sqe *sqe = getSqe_();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (static_cast<uint64_t>(st.gen) << 32) | static_cast<uint32_t>(fd);
+    sqe->user_data = REMOVE_TAG;
+    pushSqe_();
+    st.armed = false;
+}
+
+/*
+ * 确保已发布的SQE被内核取走
+ * SQPOLL：内核线程休眠时唤醒它，否则不需要系统调用
+ * 普通模式：事件循环线程阻塞在wait中时立即提交（工作线程重新注册事件），否则留到下一次wait合并提交
+ */
+void UringPoller::submit_()
+{
+    if (sqpoll_)
+    {
+        toSubmit_ = 0;
+        // note: 发布tail与读取flags之间需要全屏障，否则可能错过内核线程进入休眠
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (__atomic_load_n(sqFlags_, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+        {
+            enter_(0, 0, IORING_ENTER_SQ_WAKEUP, nullptr, 0);
+        }
+    }
+    else if (toSubmit_ > 0 && waiting_)
+    {
+        enter_(toSubmit_, 0, 0, nullptr, 0);
+        toSubmit_ = 0;
+    }
+}
+
+/*
+ * 注册事件
+ */
+bool UringPoller::addFd(int fd, uint32_t events)
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> locker(mtx_);
+    FdState &st = state_(fd);
+    // 同一个fd编号上残留的旧注册（没有调用delFd就关闭了描述符）先删除
+    if (st.armed)
+    {
+        pollRemove_(fd);
+    }
+    st.gen++;
+    st.events = events;
+    pollAdd_(fd);
+    submit_();
+    return true;
+}
+
+/*
+ * 重新注册事件
+ * EPOLLONESHOT触发后poll请求已经完成，只需要写入一个新的POLL_ADD
+ */
+bool UringPoller::modFd(int fd, uint32_t events)
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> locker(mtx_);
+    FdState &st = state_(fd);
+    // 仍在进行中的poll（multishot或尚未触发）先删除再以新的事件注册
+    if (st.armed)
+    {
+        pollRemove_(fd);
+        st.gen++;
+    }
+    st.events = events;
+    pollAdd_(fd);
+    submit_();
+    return true;
+}
+
+/*
+ * 删除事件，注册代数自增，之后到达的旧完成事件都会被丢弃
+ */
+bool UringPoller::delFd(int fd)
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> locker(mtx_);
+    FdState &st = state_(fd);
+    if (st.armed)
+    {
+        pollRemove_(fd);
+        submit_();
+    }
+    st.gen++;
+    return true;
+}
+
+/*
+ * 等待事件
+ * 普通模式下把事件循环线程自己积攒的SQE与等待合并为一次io_uring_enter
+ * 返回值与epoll_wait一致：事件个数，超时返回0，被信号中断返回-1
+ */
+int UringPoller::wait(struct epoll_event *events, int maxEvents, int timeoutMS)
+{
+    unsigned toSubmit = 0;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (!sqpoll_)
+        {
+            toSubmit = toSubmit_;
+            toSubmit_ = 0;
+        }
+        waiting_ = true;
+    }
+    // 完成队列里已经有事件时不需要阻塞
+    bool ready = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) != *cqHead_;
+    if (!ready || toSubmit > 0)
+    {
+        struct io_uring_getevents_arg arg;
+        struct __kernel_timespec ts;
+        memset(&arg, 0, sizeof(arg));
+        if (timeoutMS >= 0)
+        {
+            ts.tv_sec = timeoutMS / 1000;
+            ts.tv_nsec = (timeoutMS % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+        unsigned flags = IORING_ENTER_EXT_ARG;
+        if (!ready)
+        {
+            flags |= IORING_ENTER_GETEVENTS;
+        }
+        int ret = enter_(toSubmit, ready ? 0 : 1, flags, &arg, sizeof(arg));
+        if (ret < 0 && errno == EINTR)
+        {
+            waiting_ = false;
+            return -1;
+        }
+    }
+    waiting_ = false;
+
+    // 收割完成事件
+    std::lock_guard<std::mutex> locker(mtx_);
+    int count = 0;
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    while (head != tail && count < maxEvents)
+    {
+        struct io_uring_cqe *cqe = &cqes_[head & *cqMask_];
+        head++;
+        if (cqe->user_data == REMOVE_TAG)
+        {
+            continue;
+        }
+        int fd = static_cast<int>(cqe->user_data & 0xffffffff);
+        uint32_t gen = static_cast<uint32_t>(cqe->user_data >> 32);
+        // 已经删除或重新注册过的旧请求
+        if (static_cast<size_t>(fd) >= fdStates_.size() || fdStates_[fd].gen != gen)
+        {
+            continue;
+        }
+        FdState &st = fdStates_[fd];
+        bool more = cqe->flags & IORING_CQE_F_MORE;
+        if (!more)
+        {
+            st.armed = false;
+        }
+        // poll被内核终止（比如multishot取消或溢出），重新注册，不上报事件
+        if (cqe->res == -ECANCELED)
+        {
+            if (!(st.events & EPOLLONESHOT))
+            {
+                pollAdd_(fd);
+            }
+            continue;
+        }
+        events[count].data.fd = fd;
+        events[count].events = cqe->res < 0 ? EPOLLERR : static_cast<uint32_t>(cqe->res);
+        count++;
+        // 没有EPOLLONESHOT的poll已经结束（LT单次poll或multishot终止），重新注册
+        if (!more && !(st.events & EPOLLONESHOT) && cqe->res >= 0)
+        {
+            pollAdd_(fd);
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    // 收割过程中产生的请求：SQPOLL下唤醒内核线程，普通模式下留到下一次wait提交
+    if (sqpoll_)
+    {
+        submit_();
+    }
+    return count;
+}
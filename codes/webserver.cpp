@@ -1,13 +1,32 @@
 #include "../headers/webserver.h"
 
+// note: 503响应预先构造好，过载时不需要解析请求、拼接响应，直接send
+const char WebServer::BUSY_RESPONSE[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                        "Retry-After: 1\r\n"
+                                        "Connection: close\r\n"
+                                        "Content-Type: text/plain\r\n"
+                                        "Content-Length: 12\r\n"
+                                        "\r\n"
+                                        "Server Busy!";
+
 /*
  * 构造函数中初始化程序需要用到的资源
  */
 WebServer::WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
                      int sqlPort, const char *sqlUser, const char *sqlPwd,
                      const char *dbName, int connPoolNum, int threadNum,
-                     bool openLog, int logLevel, int logQueSize, int actor, bool is_daemon) : port_(port), openLinger_(optLinger), timeoutMS_(timeoutMS), isClose_(false),
-                                                                                              timer_(new HeapTimer()), threadPool_(new ThreadPool(threadNum)), epoller_(new Epoller()), actor_(actor), is_daemon_(is_daemon)
+                     bool openLog, int logLevel, int logQueSize, int actor, bool is_daemon,
+                     int reactorMode, int reactorNum, int balance, int ioBackend,
+                     int backlog, int acceptBatch, int timerType, bool lazyTimer,
+                     int poolMode, int maxTasks, int rejectPolicy,
+                     int codelTarget, int codelInterval, int dbThreadNum, bool pinCpu,
+                     int maxThreadNum) : port_(port), openLinger_(optLinger), timeoutMS_(timeoutMS), lazyTimer_(lazyTimer), isClose_(false),
+                                                     threadPool_(new ThreadPool(threadNum, poolMode == 1 ? ThreadPool::STEALING : (poolMode == 2 ? ThreadPool::AFFINITY : (poolMode == 3 ? ThreadPool::LOCKFREE : ThreadPool::SHARED)),
+                                                                                std::max(maxTasks, 0), (ThreadPool::POLICY)std::min(std::max(rejectPolicy, 0), 2),
+                                                                                codelTarget, codelInterval, pinCpu, std::max(maxThreadNum, 0))),
+                                                     actor_(actor), is_daemon_(is_daemon),
+                                                     reactorMode_(reactorMode), balance_(balance), backlog_(backlog > 0 ? backlog : getSomaxconn_()),
+                                                     acceptBatch_(std::max(acceptBatch, 0)), nextReactor_(0), users_(MAX_FD)
 {
     // 获取资源目录
     srcDir_ = getcwd(nullptr, 256);
@@ -19,6 +38,11 @@ WebServer::WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
     uploadDir_ = getcwd(nullptr, 256);
     assert(uploadDir_);
     strcat(uploadDir_, "/resources/upload/");
+    // 上传目录不在版本库中，不存在时创建
+    if (mkdir(uploadDir_, 0755) < 0 && errno != EEXIST)
+    {
+        LOG_ERROR("Create Upload Dir Error! %s, errno: %d", uploadDir_, errno);
+    }
 
     // 初始化http连接类的静态变量值以及数据库连接池
     HttpConn::userCount = 0;
@@ -26,11 +50,66 @@ WebServer::WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
     HttpConn::uploadDir = uploadDir_;
     SqlConnPool::instance()->init("localhost", sqlPort, sqlUser, sqlPwd, dbName, connPoolNum);
 
+    // 数据库线程池，队列长度和拒绝策略与工作线程池相同
+    if (dbThreadNum > 0)
+    {
+        dbPool_.reset(new ThreadPool(dbThreadNum, ThreadPool::SHARED, std::max(maxTasks, 0),
+                                     (ThreadPool::POLICY)std::min(std::max(rejectPolicy, 0), 2)));
+    }
+
     // 根据参数设置连接事件与监听事件的触发模式LT或ET
     initEventMode_(trigMode);
 
-    // 初始化监听套接字和管道套接字
-    if (!initSocket_() || !initPipe_())
+    // 创建事件循环，单Reactor模式下只有主线程一个Reactor
+    // 多Reactor模式下默认每个核一个Reactor，0号Reactor运行在主线程
+    // 主从Reactor模式下0号Reactor只负责accept，另外创建reactorNum个子Reactor负责连接的读写
+    if (reactorMode_ == 0 || reactorNum <= 0)
+    {
+        reactorNum = reactorMode_ == 0 ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (reactorMode_ == 2)
+    {
+        reactorNum++;
+    }
+    // Reactor总数不超过MAX_REACTOR
+    if (reactorNum > MAX_REACTOR)
+    {
+        reactorNum = MAX_REACTOR;
+    }
+    for (int i = 0; i < reactorNum; i++)
+    {
+        std::unique_ptr<Reactor> reactor(new Reactor());
+        reactor->id = i;
+        reactor->listenFd = -1;
+        reactor->wakeupFd = -1;
+        reactor->connCount = 0;
+        reactor->now = Clock::now();
+        reactor->acceptPending = false;
+        reactor->acceptCount = 0;
+        reactor->overflowCount = 0;
+        reactor->batchFullCount = 0;
+        if (timerType == 1)
+        {
+            reactor->timer.reset(new TimeWheel());
+        }
+        else
+        {
+            reactor->timer.reset(new HeapTimer());
+        }
+        reactor->epoller.reset(new Epoller(1024, ioBackend == 2 ? Epoller::URING_SQPOLL : ioBackend == 1 ? Epoller::URING : Epoller::EPOLL));
+        reactors_.push_back(std::move(reactor));
+    }
+
+    // 初始化监听套接字和管道套接字，每个Reactor都有自己的SO_REUSEPORT监听套接字，由内核将新连接分散到各个Reactor
+    for (auto &reactor : reactors_)
+    {
+        if (!initSocket_(reactor.get()) || !initWakeup_(reactor.get()))
+        {
+            isClose_ = true;
+            break;
+        }
+    }
+    if (!isClose_ && !initPipe_())
     {
         isClose_ = true;
     }
@@ -56,10 +135,34 @@ WebServer::WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
                      (listenEvent_ & EPOLLET ? "ET" : "LT"),
                      (connEvent_ & EPOLLET ? "ET" : "LT"));
             LOG_INFO("Actor Mode: %s", actor_ ? "Proactor" : "Reactor");
+            LOG_INFO("Connection Owner: %s", singleOwner_ ? "Single Owner" : "EPOLLONESHOT");
+            LOG_INFO("Reactor Mode: %s, Reactor num: %d",
+                     reactorMode_ == 0 ? "Single Reactor" : (reactorMode_ == 1 ? "Multi Reactor(SO_REUSEPORT)" : "Main-Sub Reactor"),
+                     (int)reactors_.size());
+            if (reactorMode_ == 2)
+            {
+                LOG_INFO("Balance: %s", balance_ ? "Least Connections" : "Round Robin");
+            }
+            LOG_INFO("Listen Backlog: %d, Accept Batch: %d", backlog_, acceptBatch_);
+            LOG_INFO("Timer: %s, Lazy Refresh: %s", timerType == 1 ? "TimeWheel" : "HeapTimer", lazyTimer_ ? "On" : "Off");
+            LOG_INFO("IO Backend: %s", reactors_[0]->epoller->backend() == Epoller::URING_SQPOLL ? "io_uring(SQPOLL)" : reactors_[0]->epoller->backend() == Epoller::URING ? "io_uring" : "epoll");
+            LOG_INFO("HTTP Scanner: %s", SimdScan::isa());
             LOG_INFO("LogSys Status: %s", openLog ? "Open" : "Close");
             LOG_INFO("Log level: %d", logLevel);
             LOG_INFO("DataBase: %s, SqlUser: %s, SqlPort: %d", dbName, sqlUser, sqlPort);
-            LOG_INFO("SqlConnPool num: %d, ThreadPool num: %d", connPoolNum, threadNum);
+            LOG_INFO("SqlConnPool num: %d, ThreadPool num: %d, DB ThreadPool num: %d", connPoolNum, threadNum, std::max(dbThreadNum, 0));
+            if (poolMode == 0 && maxThreadNum > threadNum)
+            {
+                LOG_INFO("ThreadPool Dynamic Size: %d~%d", threadNum, maxThreadNum);
+            }
+            LOG_INFO("ThreadPool Mode: %s, Pin CPU: %s",
+                     poolMode == 1 ? "Work Stealing" : (poolMode == 2 ? "Fd Affinity" : (poolMode == 3 ? "Lock-free Ring" : "Shared Queue")), pinCpu ? "On" : "Off");
+            LOG_INFO("ThreadPool Max Tasks: %d, Reject Policy: %s", std::max(maxTasks, 0),
+                     rejectPolicy == 1 ? "Caller Runs" : (rejectPolicy == 2 ? "Drop Oldest" : "Reject"));
+            if (codelTarget > 0)
+            {
+                LOG_INFO("CoDel Target: %dms, Interval: %dms", codelTarget, codelInterval);
+            }
             LOG_INFO("srcDir: %s", srcDir_);
             LOG_INFO("TimeOut: %ds", timeoutMS / 1000);
         }
@@ -71,11 +174,22 @@ WebServer::WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
  */
 WebServer::~WebServer()
 {
-    // 关闭监听描述符
-    close(listenFd_);
     isClose_ = true;
+    // 关闭各Reactor的监听描述符和唤醒描述符
+    for (auto &reactor : reactors_)
+    {
+        if (reactor->listenFd >= 0)
+        {
+            close(reactor->listenFd);
+        }
+        if (reactor->wakeupFd >= 0)
+        {
+            close(reactor->wakeupFd);
+        }
+    }
     // 释放文件资源
     free(srcDir_);
+    free(uploadDir_);
     // 关闭数据库连接池
     SqlConnPool::instance()->closePool();
     // 关闭信号管道
@@ -126,6 +240,13 @@ void WebServer::initEventMode_(int trigMode)
     }
     // 若连接事件为ET模式，那么设置HttpConn类中的标记isET为true
     HttpConn::isET = (connEvent_ & EPOLLET);
+    // Reactor模式并且连接为ET时使用单所有者模式：连接一次性注册读写事件，不再需要EPOLLONESHOT
+    // Proactor模式下主线程会直接读写连接，LT模式下常驻的EPOLLOUT会不断触发，这两种情况仍然使用EPOLLONESHOT
+    singleOwner_ = (actor_ == 0 && HttpConn::isET);
+    if (singleOwner_)
+    {
+        connEvent_ = (connEvent_ & ~EPOLLONESHOT) | EPOLLOUT;
+    }
 }
 
 /*
@@ -145,13 +266,61 @@ void WebServer::sendError_(int fd, const char *info)
 }
 
 /*
- * 删除epoller描述符监听事件，关闭连接
+ * 线程池任务队列已满或CoDel判定过载，任务被拒绝（或被丢弃）时调用，可能在任意线程中调用
+ * 此时没有其他线程在处理该连接（EPOLLONESHOT没有重新注册，或者单所有者模式下所有权在被拒绝的任务中）
+ * 先读空接收缓冲区，否则close时内核会发送RST，客户端可能收不到503响应
  */
-void WebServer::closeConn_(HttpConn *client)
+void WebServer::rejectConn_(Reactor *reactor, HttpConn *client)
 {
-    assert(client);
-    epoller_->delFd(client->getFd());
+    assert(reactor && client);
+    int fd = client->getFd();
+    char buf[4096];
+    while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+    {
+    }
+    // 直接向Socket发送503响应
+    if (send(fd, BUSY_RESPONSE, sizeof(BUSY_RESPONSE) - 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+    {
+        LOG_WARN("Send 503 to Client[%d] Error!", fd);
+    }
+    // 立即发送FIN，不等Reactor线程close
+    shutdown(fd, SHUT_WR);
+    // 由Reactor线程关闭
+    postClose_(reactor, client);
+}
+
+/*
+ * 删除epoller描述符监听事件和定时器，关闭连接，只在连接所属的Reactor线程中调用
+ * note: 定时器必须同时删除，否则close之后fd被其他Reactor复用时，本Reactor的旧定时器到期会关闭新连接
+ */
+void WebServer::closeConn_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    // 连接可能已经被关闭（比如定时器到期时连接已经因为错误关闭了）
+    if (client->isClosed())
+    {
+        return;
+    }
+    if (timeoutMS_ > 0)
+    {
+        reactor->timer->cancel(client->getFd());
+    }
+    reactor->epoller->delFd(client->getFd());
     client->close();
+    reactor->connCount--;
+}
+
+/*
+ * 请求关闭连接（超时、出错或对端关闭），在Reactor线程中调用
+ * 单所有者模式下如果有工作线程正在处理该连接，则只记录CLOSE事件，由所有者关闭，避免与工作线程竞争
+ */
+void WebServer::dealClose_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    if (!singleOwner_ || client->postEvents(HttpConn::CLOSE))
+    {
+        closeConn_(reactor, client);
+    }
 }
 
 /*
@@ -169,14 +338,40 @@ int WebServer::setFdNonblock(int fd)
     return old_option;
 }
 
+/*
+ * 读取系统的监听队列上限，listen的backlog超过该值时会被内核截断
+ */
+int WebServer::getSomaxconn_()
+{
+    int somaxconn = SOMAXCONN;
+    FILE *fp = fopen("/proc/sys/net/core/somaxconn", "r");
+    if (fp)
+    {
+        if (fscanf(fp, "%d", &somaxconn) != 1 || somaxconn <= 0)
+        {
+            somaxconn = SOMAXCONN;
+        }
+        fclose(fp);
+    }
+    return somaxconn;
+}
+
 /*
  * 创建监听描述符，设置端口复用，bind，listen，添加epoll监听fd，设置非阻塞
+ * 单Reactor模式下只有0号Reactor创建监听描述符
+ * 多Reactor模式下每个Reactor都创建一个开启SO_REUSEPORT的监听描述符，绑定同一端口
  */
-bool WebServer::initSocket_()
+bool WebServer::initSocket_(Reactor *reactor)
 {
     int ret = 0;
     struct sockaddr_in addr;
 
+    assert(reactor);
+    // 单Reactor模式和主从Reactor模式下只有主Reactor负责accept
+    if (reactorMode_ != 1 && reactor->id != 0)
+    {
+        return true;
+    }
     // 合法性检查
     if (port_ > 65535 || port_ < 1024)
     {
@@ -187,9 +382,9 @@ bool WebServer::initSocket_()
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     addr.sin_port = htons(port_);
-    // 创建监听套接字
-    listenFd_ = socket(PF_INET, SOCK_STREAM, 0);
-    if (listenFd_ < 0)
+    // 创建监听套接字，直接创建为非阻塞，并且exec时自动关闭
+    int listenFd = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
     {
         LOG_ERROR("Create Socket Error!");
         return false;
@@ -203,10 +398,10 @@ bool WebServer::initSocket_()
         optLinger.l_linger = 1;
     }
     // 设置连接选项，是否优雅关闭连接
-    ret = setsockopt(listenFd_, SOL_SOCKET, SO_LINGER, &optLinger, sizeof(optLinger));
+    ret = setsockopt(listenFd, SOL_SOCKET, SO_LINGER, &optLinger, sizeof(optLinger));
     if (ret < 0)
     {
-        close(listenFd_);
+        close(listenFd);
         LOG_ERROR("Init Linger Error!");
         return false;
     }
@@ -214,40 +409,50 @@ bool WebServer::initSocket_()
     int optVal = 1;
     // 端口复用，SO_REUSEADDR 立即开启这个端口，不用管之前关闭连接后的2MSL
     // 只有最后一个套接字会正常接收数据
-    ret = setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, (const void *)&optVal, sizeof(int));
+    ret = setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, (const void *)&optVal, sizeof(int));
     if (ret < 0)
     {
         LOG_ERROR("Set Socket Reuse Address Error!");
-        close(listenFd_);
+        close(listenFd);
         return false;
     }
+    // 多Reactor模式下开启SO_REUSEPORT，多个监听套接字绑定同一端口，内核按四元组哈希将新连接分配给其中一个
+    if (reactorMode_ == 1)
+    {
+        ret = setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, (const void *)&optVal, sizeof(int));
+        if (ret < 0)
+        {
+            LOG_ERROR("Set Socket Reuse Port Error!");
+            close(listenFd);
+            return false;
+        }
+    }
     // 绑定套接字监听地址
-    ret = bind(listenFd_, (struct sockaddr *)&addr, sizeof(addr));
+    ret = bind(listenFd, (struct sockaddr *)&addr, sizeof(addr));
     if (ret < 0)
     {
         LOG_ERROR("Bind Socket Error!");
-        close(listenFd_);
+        close(listenFd);
         return false;
     }
-    // 开始监听，socket可以排队的最大连接数最大6个
-    ret = listen(listenFd_, 6);
+    // 开始监听，全连接队列长度为backlog_（默认为somaxconn），队列太短时连接风暴下会丢弃SYN
+    ret = listen(listenFd, backlog_);
     if (ret < 0)
     {
         LOG_ERROR("Listen Port: %d Error!", port_);
-        close(listenFd_);
+        close(listenFd);
         return false;
     }
     // 将监听描述符加入到epoll的监听事件中，监听EPOLLIN读事件
-    bool res = epoller_->addFd(listenFd_, listenEvent_ | EPOLLIN);
+    bool res = reactor->epoller->addFd(listenFd, listenEvent_ | EPOLLIN);
     if (!res)
     {
         LOG_ERROR("Add Epoll Listen Error!");
-        close(listenFd_);
+        close(listenFd);
         return false;
     }
-    // 设置监听事件为非阻塞
-    setFdNonblock(listenFd_);
-    LOG_INFO("Server Init Success! Server Port is: %d", port_);
+    reactor->listenFd = listenFd;
+    LOG_INFO("Reactor[%d] Init Success! Server Port is: %d", reactor->id, port_);
 
     return true;
 }
@@ -260,8 +465,8 @@ bool WebServer::initPipe_()
     // 新建管道Socket
     int ret = socketpair(PF_UNIX, SOCK_STREAM, 0, pipefd_);
     assert(ret != -1);
-    // 增加epoll事件
-    ret = epoller_->addFd(pipefd_[0], EPOLLRDHUP | EPOLLIN);
+    // 增加epoll事件，信号只由主Reactor处理
+    ret = reactors_[0]->epoller->addFd(pipefd_[0], EPOLLRDHUP | EPOLLIN);
     // 返回值为false，错误
     if (!ret)
     {
@@ -281,34 +486,172 @@ bool WebServer::initPipe_()
     return true;
 }
 
+/*
+ * 初始化唤醒Reactor的eventfd
+ * 用于主Reactor通知子Reactor有新连接投递，以及关闭服务器时唤醒阻塞在epoll_wait上的Reactor线程
+ */
+bool WebServer::initWakeup_(Reactor *reactor)
+{
+    assert(reactor);
+    reactor->wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->wakeupFd < 0)
+    {
+        LOG_ERROR("Create Reactor[%d] Eventfd Error!", reactor->id);
+        return false;
+    }
+    if (!reactor->epoller->addFd(reactor->wakeupFd, EPOLLIN))
+    {
+        LOG_ERROR("Add Reactor[%d] Eventfd Error!", reactor->id);
+        close(reactor->wakeupFd);
+        reactor->wakeupFd = -1;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * 唤醒指定Reactor，向其eventfd写入计数
+ */
+void WebServer::wakeup_(Reactor *reactor)
+{
+    assert(reactor);
+    uint64_t one = 1;
+    ssize_t ret = write(reactor->wakeupFd, &one, sizeof(one));
+    if (ret != sizeof(one))
+    {
+        LOG_WARN("Wakeup Reactor[%d] Error!", reactor->id);
+    }
+}
+
+/*
+ * 处理唤醒事件，读出eventfd的计数，并接收主Reactor投递过来的所有新连接
+ */
+void WebServer::dealWakeup_(Reactor *reactor)
+{
+    assert(reactor);
+    uint64_t count = 0;
+    read(reactor->wakeupFd, &count, sizeof(count));
+    // 先读eventfd再取队列，这样读之后投递的连接一定会再次触发唤醒，不会遗漏
+    Handoff handoff;
+    while (reactor->handoffs.pop(handoff))
+    {
+        addClient_(reactor, handoff.fd, handoff.addr);
+    }
+}
+
+/*
+ * 关闭工作线程请求关闭的连接，在每轮事件处理完之后调用
+ * note: 不能在dealWakeup_中关闭，本轮后面的监听事件可能accept到复用同一fd的新连接，
+ * 而本轮事件里该fd的旧事件（比如对端RST产生的EPOLLHUP）还没有处理，会被分发给新连接
+ */
+void WebServer::dealPendingClose_(Reactor *reactor)
+{
+    assert(reactor);
+    std::vector<HttpConn *> toClose;
+    {
+        std::lock_guard<std::mutex> locker(reactor->closeMtx);
+        toClose.swap(reactor->toClose);
+    }
+    for (HttpConn *client : toClose)
+    {
+        closeConn_(reactor, client);
+    }
+}
+
+/*
+ * 主从Reactor模式下选择接收新连接的子Reactor（1号到最后一个）
+ * 轮询：依次分配；最少连接：选择当前连接数最少的子Reactor
+ */
+WebServer::Reactor *WebServer::selectSubReactor_()
+{
+    assert(reactors_.size() > 1);
+    size_t subNum = reactors_.size() - 1;
+    if (balance_ == 1)
+    {
+        Reactor *target = reactors_[1].get();
+        for (size_t i = 2; i <= subNum; i++)
+        {
+            if (reactors_[i]->connCount < target->connCount)
+            {
+                target = reactors_[i].get();
+            }
+        }
+        return target;
+    }
+    nextReactor_ = nextReactor_ % subNum + 1;
+    return reactors_[nextReactor_].get();
+}
+
 /*
  * 处理客户端连接事件
+ * 主从Reactor模式下主Reactor只负责accept，然后通过无锁队列把连接投递给子Reactor，
+ * 并在本轮accept结束后用eventfd唤醒收到新连接的子Reactor（每个子Reactor只唤醒一次）
+ * 每次最多accept acceptBatch_个连接，用完上限时设置acceptPending，由事件循环在处理完本轮读写事件后继续accept
  */
-void WebServer::dealListen_()
+void WebServer::dealListen_(Reactor *reactor)
 {
     struct sockaddr_in addr;
     socklen_t len = sizeof(addr);
+    uint64_t toWake = 0; // 需要唤醒的子Reactor，第i位对应i号Reactor
+    int accepted = 0;
 
-    // 使用do-while很巧妙，因为无论如何都会进入一次循环体，如果监听事件设置为LT模式，则只会调用一次accept与addClient方法
-    // 若监听事件是ET模式，则会将连接一次性接受完，直到accept返回-1，表示当前没有连接了
-    do
+    reactor->acceptPending = false;
+    // 无论LT还是ET都一直accept到EAGAIN或者用完批量上限
+    // LT模式下剩余的连接会再次触发监听事件，ET模式下不会，所以ET模式需要acceptPending记录
+    while (true)
     {
-        int fd = accept(listenFd_, (struct sockaddr *)&addr, &len);
+        if (acceptBatch_ > 0 && accepted >= acceptBatch_)
+        {
+            reactor->batchFullCount++;
+            reactor->acceptPending = (listenEvent_ & EPOLLET);
+            break;
+        }
+        // note: accept4直接返回非阻塞、exec时自动关闭的描述符，省去了之后的fcntl系统调用
+        len = sizeof(addr);
+        int fd = accept4(reactor->listenFd, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         // 因为设置fd非阻塞，所以当accept返回-1说明没有新连接，就可以出循环
         if (fd < 0)
         {
-            return;
+            break;
         }
-        else if (HttpConn::userCount >= MAX_FD)
+        accepted++;
+        reactor->acceptCount++;
+        if (HttpConn::userCount >= MAX_FD || fd >= MAX_FD)
         {
             // 当前连接数太多，超过了预定义了最大数量，向客户端发送错误信息
+            reactor->overflowCount++;
             sendError_(fd, "Server Busy!");
             LOG_WARN("Clients is Full!");
-            return;
+            continue;
+        }
+        // 单Reactor和多Reactor模式下由本Reactor负责该连接
+        if (reactorMode_ != 2)
+        {
+            // 添加客户端
+            addClient_(reactor, fd, addr);
+            continue;
+        }
+        // 主从Reactor模式下投递给子Reactor
+        Reactor *sub = selectSubReactor_();
+        // 先计数，保证最少连接策略在子Reactor处理投递之前就能看到这个连接
+        sub->connCount++;
+        if (!sub->handoffs.push({fd, addr}))
+        {
+            sub->connCount--;
+            reactor->overflowCount++;
+            sendError_(fd, "Server Busy!");
+            LOG_WARN("Reactor[%d] Handoff Queue is Full!", sub->id);
+            continue;
         }
-        // 添加客户端
-        addClient_(fd, addr);
-    } while (listenEvent_ & EPOLLET);
+        toWake |= 1ull << sub->id;
+    }
+
+    // 依次唤醒位图中的子Reactor，每次取最低位
+    while (toWake)
+    {
+        wakeup_(reactors_[__builtin_ctzll(toWake)].get());
+        toWake &= toWake - 1;
+    }
 }
 
 /*
@@ -347,59 +690,114 @@ void WebServer::dealSignal_()
 /*
  * 初始化httpconn类对象，添加对应连接的计时器，添加epoll监听事件
  */
-void WebServer::addClient_(int fd, sockaddr_in addr)
+void WebServer::addClient_(Reactor *reactor, int fd, sockaddr_in addr)
 {
-    assert(fd > 0);
+    assert(reactor && fd > 0);
     // 初始化httpconn类对象
-    users_[fd].init(fd, addr);
+    HttpConn *client = users_.get(fd);
+    client->init(fd, addr);
+    // 主从Reactor模式下主Reactor投递时已经计数
+    if (reactorMode_ != 2)
+    {
+        reactor->connCount++;
+    }
     if (timeoutMS_ > 0)
     {
         // 若设置了超时事件，则需要向定时器里添加这一项，设置回调函数为关闭连接
-        // note: std::bind，函数适配器，接受一个可调用对象，生成一个新的可调用对象来适应原对象的参数列表
-        timer_->add(fd, timeoutMS_, std::bind(&WebServer::closeConn_, this, &users_[fd]));
+        // note: 回调函数使用只捕获指针的lambda，可以直接存放在定长的Task中，不需要std::bind和堆内存分配
+        // 惰性定时器模式下回调函数先检查最近一次活动时间
+        if (lazyTimer_)
+        {
+            client->setLastActive(reactor->now);
+            reactor->timer->add(fd, timeoutMS_, [this, reactor, client]
+                                { dealTimeout_(reactor, client); });
+        }
+        else
+        {
+            reactor->timer->add(fd, timeoutMS_, [this, reactor, client]
+                                { dealClose_(reactor, client); });
+        }
     }
-    // 添加epoll监听EPOLLIN事件
-    epoller_->addFd(fd, EPOLLIN | connEvent_);
-    // 文件描述符设置为非阻塞
-    setFdNonblock(fd);
+    // 添加epoll监听EPOLLIN事件（单所有者模式下connEvent_已经包含EPOLLOUT，之后不再修改）
+    // 描述符在accept4时已经设置为非阻塞
+    reactor->epoller->addFd(fd, EPOLLIN | connEvent_);
 }
 
 /*
  * 表示对应连接上有读写事件发生，需要调整计时器中的过期时间
  */
-void WebServer::extentTime_(HttpConn *client)
+void WebServer::extentTime_(Reactor *reactor, HttpConn *client)
 {
-    assert(client);
+    assert(reactor && client);
     if (timeoutMS_ > 0)
     {
+        // 惰性定时器模式下只记录活动时间，一次写入，不需要调整定时器
+        if (lazyTimer_)
+        {
+            client->setLastActive(reactor->now);
+            return;
+        }
         // 调整fd对应的定时器的超时时间为初始设定值timeoutMS_
-        timer_->adjust(client->getFd(), timeoutMS_);
+        reactor->timer->adjust(client->getFd(), timeoutMS_);
+    }
+}
+
+/*
+ * 惰性定时器模式下的超时回调，在Reactor线程的定时器中调用
+ * 连接在定时器添加之后有过活动时，真正的截止时间是最近一次活动时间+timeoutMS_，按剩余时间重新调度
+ */
+void WebServer::dealTimeout_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    TimeStamp deadline = client->getLastActive() + MS(timeoutMS_);
+    int remain = std::chrono::duration_cast<MS>(deadline - reactor->now).count();
+    if (remain > 0)
+    {
+        reactor->timer->add(client->getFd(), remain, [this, reactor, client]
+                            { dealTimeout_(reactor, client); });
+        return;
     }
+    dealClose_(reactor, client);
 }
 
 /*
  * 解析HTTP请求报文并生成HTTP响应报文
  */
-void WebServer::onProcess_(HttpConn *client)
+void WebServer::onProcess_(Reactor *reactor, HttpConn *client)
 {
+    bool ready = client->process();
+    // 登录、注册请求交给数据库线程池，在onVerify_中生成响应后再注册EPOLLOUT事件
+    if (!ready && client->needsVerify())
+    {
+        if (dbPool_)
+        {
+            dbPool_->addTask([this, reactor, client]
+                             { onVerify_(reactor, client); },
+                             [this, reactor, client]
+                             { rejectConn_(reactor, client); });
+            return;
+        }
+        client->verify();
+        ready = true;
+    }
     // 成功解析请求和生成响应后，将epoll在该文件描述符上的监听事件改为EPOLLOUT写事件，准备写HTTP响应报文
     // 如果是解析失败，在process()函数里会生成异常响应HTTP报文，直接返回给客户端400错误
-    if (client->process())
+    if (ready)
     {
-        epoller_->modFd(client->getFd(), connEvent_ | EPOLLOUT);
+        reactor->epoller->modFd(client->getFd(), connEvent_ | EPOLLOUT);
     }
     // 注意这里不是解析失败，解析失败在上面if中
     // 数据还没有读完或没有数据可读，需要继续使用epoll监听该连接上的EPOLLIN读事件
     else
     {
-        epoller_->modFd(client->getFd(), connEvent_ | EPOLLIN);
+        reactor->epoller->modFd(client->getFd(), connEvent_ | EPOLLIN);
     }
 }
 
 /*
  * 读取socket传来的数据，并调用onProcess函数处理
  */
-void WebServer::onRead_(HttpConn *client)
+void WebServer::onRead_(Reactor *reactor, HttpConn *client)
 {
     assert(client);
     int ret = -1;
@@ -409,28 +807,33 @@ void WebServer::onRead_(HttpConn *client)
     ret = client->read(&readErrno);
     if (ret <= 0 && readErrno != EAGAIN)
     {
-        // 若返回值小于0，且信号不为EAGAIN说明发生了错误
-        closeConn_(client);
+        // 若返回值小于0，且信号不为EAGAIN说明发生了错误，在工作线程中，交给Reactor线程关闭
+        postClose_(reactor, client);
         return;
     }
     // 读取成功，此时数据保存在HttpConn *client的readBuff_中
     // 调用onProcess_()函数解析数据，执行业务逻辑
-    onProcess_(client);
+    onProcess_(reactor, client);
 }
 
 /*
  * 处理连接中的读取数据事件，调整当前连接的过期时间，向线程池中添加读数据的任务
  */
-void WebServer::dealRead_(HttpConn *client)
+void WebServer::dealRead_(Reactor *reactor, HttpConn *client)
 {
     assert(client);
     // 调整过期时间
-    extentTime_(client);
+    extentTime_(reactor, client);
     // 如果是Reactor模式
     if (actor_ == 0)
     {
         // 添加线程池任务，运行onRead_()函数
-        threadPool_->addTask(std::bind(&WebServer::onRead_, this, client));
+        // note: 以fd为键，亲和模式下同一连接的任务总是由同一个工作线程执行，连接的缓冲区等状态留在该线程所在核的缓存中
+        threadPool_->addTask([this, reactor, client]
+                             { onRead_(reactor, client); },
+                             [this, reactor, client]
+                             { rejectConn_(reactor, client); },
+                             client->getFd());
     }
     // Proactor模式（同步模拟）
     // 相当于把onRead_()拿到主线程运行读取，子线程运行onProcess_()解析并处理业务
@@ -443,19 +846,23 @@ void WebServer::dealRead_(HttpConn *client)
         if (ret <= 0 && readErrno != EAGAIN)
         {
             // 若返回值小于0，且信号不为EAGAIN说明发生了错误
-            closeConn_(client);
+            closeConn_(reactor, client);
             return;
         }
         // 读取成功，此时数据保存在HttpConn *client的readBuff_中
         // 调用onProcess_()函数解析数据，执行业务逻辑
-        threadPool_->addTask(std::bind(&WebServer::onProcess_, this, client));
+        threadPool_->addTask([this, reactor, client]
+                             { onProcess_(reactor, client); },
+                             [this, reactor, client]
+                             { rejectConn_(reactor, client); },
+                             client->getFd());
     }
 }
 
 /*
  * 向对应的socket发送数据
  */
-void WebServer::onWrite_(HttpConn *client)
+void WebServer::onWrite_(Reactor *reactor, HttpConn *client)
 {
     assert(client);
     int ret = -1;
@@ -468,11 +875,26 @@ void WebServer::onWrite_(HttpConn *client)
         // 检查客户端是否设置了长连接字段
         if (client->isKeepAlive())
         {
-            // note: 如果客户端设置了长连接，那么调用OnProcess_()函数
-            // 因为此时的client->process()会返回false，所以该连接会重新注册epoll的EPOLLIN事件
-            // onProcess_(client);
-            // 这里直接设置epoll监听该连接上的EPOLLIN读事件也可以
-            epoller_->modFd(client->getFd(), connEvent_ | EPOLLIN);
+            // note: 流水线请求：读缓冲区中可能还有已经读到但没处理的请求（或等待验证的请求），
+            // 这些数据不会再触发EPOLLIN，需要调用onProcess_()继续解析，Proactor模式下交给线程池
+            if (client->hasPendingRequest())
+            {
+                if (actor_ == 0)
+                {
+                    onProcess_(reactor, client);
+                }
+                else
+                {
+                    threadPool_->addTask([this, reactor, client]
+                                         { onProcess_(reactor, client); },
+                                         [this, reactor, client]
+                                         { rejectConn_(reactor, client); },
+                                         client->getFd());
+                }
+                return;
+            }
+            // 没有剩余的请求，直接设置epoll监听该连接上的EPOLLIN读事件
+            reactor->epoller->modFd(client->getFd(), connEvent_ | EPOLLIN);
             // 此时直接返回，不关闭连接
             return;
         }
@@ -484,47 +906,242 @@ void WebServer::onWrite_(HttpConn *client)
         if (writeErrno == EAGAIN)
         {
             // 重新注册该连接的EPOLLOUT事件
-            epoller_->modFd(client->getFd(), connEvent_ | EPOLLOUT);
+            reactor->epoller->modFd(client->getFd(), connEvent_ | EPOLLOUT);
             return;
         }
     }
-    // 其余情况，关闭连接
-    closeConn_(client);
+    // 其余情况，关闭连接，Reactor模式下在工作线程中，交给Reactor线程关闭
+    if (actor_ == 0)
+    {
+        postClose_(reactor, client);
+    }
+    else
+    {
+        closeConn_(reactor, client);
+    }
 }
 
 /*
  * 处理连接中的发送数据事件，调整当前连接的过期时间，向线程池中添加发送数据的任务
  */
-void WebServer::dealWrite_(HttpConn *client)
+void WebServer::dealWrite_(Reactor *reactor, HttpConn *client)
 {
     assert(client);
     // 调整过期时间
-    extentTime_(client);
+    extentTime_(reactor, client);
     // 如果是Reactor模式
     if (actor_ == 0)
     {
         // 添加线程池任务，运行onWrite_()函数
-        threadPool_->addTask(std::bind(&WebServer::onWrite_, this, client));
+        threadPool_->addTask([this, reactor, client]
+                             { onWrite_(reactor, client); },
+                             [this, reactor, client]
+                             { rejectConn_(reactor, client); },
+                             client->getFd());
     }
     // Proactor模式（同步模拟），把onWrite_()拿到主线程运行写入
     else
     {
-        onWrite_(client);
+        onWrite_(reactor, client);
+    }
+}
+
+/*
+ * 单所有者模式：记录连接上的就绪事件
+ * 只有获得所有权（之前没有线程在处理该连接）时才向线程池添加任务，否则当前所有者会处理这些事件
+ */
+void WebServer::dealEvent_(Reactor *reactor, HttpConn *client, uint32_t events)
+{
+    assert(reactor && client);
+    uint32_t connEvents = 0;
+    if (events & EPOLLIN)
+    {
+        connEvents |= HttpConn::READABLE;
+    }
+    if (events & EPOLLOUT)
+    {
+        connEvents |= HttpConn::WRITABLE;
+    }
+    // 调整过期时间
+    extentTime_(reactor, client);
+    if (client->postEvents(connEvents))
+    {
+        threadPool_->addTask([this, reactor, client]
+                             { onEvent_(reactor, client); },
+                             [this, reactor, client]
+                             { rejectConn_(reactor, client); },
+                             client->getFd());
     }
 }
 
+/*
+ * 单所有者模式：持有连接所有权，依次处理读、解析、写，没有新事件后释放所有权
+ * ET模式下读写都进行到EAGAIN为止，发送缓冲区满时等待下一次EPOLLOUT边沿，不需要重新注册事件
+ * 需要关闭连接时不在工作线程中close，而是交给Reactor线程，并且一直持有所有权，屏蔽之后到达的事件
+ */
+void WebServer::onEvent_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    do
+    {
+        uint32_t events = client->takeEvents();
+        // 超时或出错，交给Reactor关闭，不再释放所有权，连接重新init时重置
+        if (events & HttpConn::CLOSE)
+        {
+            postClose_(reactor, client);
+            return;
+        }
+        if (events & HttpConn::READABLE)
+        {
+            int readErrno = 0;
+            // 调用httpconn类的read方法，读取数据直到EAGAIN
+            ssize_t ret = client->read(&readErrno);
+            if (ret <= 0 && readErrno != EAGAIN)
+            {
+                postClose_(reactor, client);
+                return;
+            }
+        }
+        // 流水线请求的响应在连接中排队，process()解析读缓冲区中所有完整的请求，write()一次writev发送所有响应
+        // 发完之后如果读缓冲区里还有数据（队列满或者等待验证时剩下的请求），继续解析
+        while (true)
+        {
+            if (!client->process())
+            {
+                // 读缓冲区达到上限时停止了读取，socket中可能还有数据，读缓冲区已经消费，继续读
+                if (!client->needsVerify() && client->readPaused())
+                {
+                    int readErrno = 0;
+                    ssize_t ret = client->read(&readErrno);
+                    if (ret <= 0 && readErrno != EAGAIN)
+                    {
+                        postClose_(reactor, client);
+                        return;
+                    }
+                    continue;
+                }
+                // 请求不完整或没有数据，等待下一次EPOLLIN
+                if (!client->needsVerify())
+                {
+                    break;
+                }
+                // 登录、注册请求交给数据库线程池，不释放所有权，验证完成后由onVerify_继续处理
+                if (dbPool_)
+                {
+                    dbPool_->addTask([this, reactor, client]
+                                     { onVerify_(reactor, client); },
+                                     [this, reactor, client]
+                                     { rejectConn_(reactor, client); });
+                    return;
+                }
+                client->verify();
+            }
+            int writeErrno = 0;
+            ssize_t ret = client->write(&writeErrno);
+            if (client->toWriteBytes() > 0)
+            {
+                // 发送缓冲区满，等待下一次EPOLLOUT边沿
+                if (ret < 0 && writeErrno == EAGAIN)
+                {
+                    break;
+                }
+                postClose_(reactor, client);
+                return;
+            }
+            // 响应发送完毕，短连接直接关闭
+            if (!client->isKeepAlive())
+            {
+                postClose_(reactor, client);
+                return;
+            }
+        }
+    } while (!client->releaseOwner());
+}
+
+/*
+ * 在数据库线程池中运行：进行用户验证并生成响应
+ * 单所有者模式下任务持有连接的所有权，继续执行onEvent_发送响应、处理之后的事件
+ * EPOLLONESHOT模式下连接在验证期间没有注册事件，验证完成后注册EPOLLOUT，由工作线程发送响应
+ */
+void WebServer::onVerify_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    client->verify();
+    if (singleOwner_)
+    {
+        onEvent_(reactor, client);
+        return;
+    }
+    reactor->epoller->modFd(client->getFd(), connEvent_ | EPOLLOUT);
+}
+
+/*
+ * 工作线程请求Reactor关闭连接，定时器只能在Reactor线程中修改
+ * note: 单所有者模式下连接一直注册在epoll中，Reactor本轮epoll_wait取出的事件里可能还有该fd的旧事件
+ * 如果工作线程直接close，Reactor随后accept到复用同一个fd的新连接，旧事件（比如EPOLLRDHUP）会被错误地分发给新连接
+ * 所以close只在Reactor线程处理完一轮事件之后进行（见dealPendingClose_）
+ */
+void WebServer::postClose_(Reactor *reactor, HttpConn *client)
+{
+    assert(reactor && client);
+    {
+        std::lock_guard<std::mutex> locker(reactor->closeMtx);
+        reactor->toClose.push_back(client);
+    }
+    wakeup_(reactor);
+}
+
 /*
  * 启动服务器
+ * 其余Reactor各自在独立线程中运行事件循环，0号Reactor在主线程运行事件循环并处理信号
  */
 void WebServer::start()
 {
-    // epoll wait timeout == -1 无事件将阻塞
-    // 如果timeout大于0时才会设置超时信号，后面可以改为根据最接近的超时事件设置超时时长
-    int timeMS = -1;
     if (!isClose_)
     {
         LOG_INFO("=========================Server Start=========================");
     }
+    for (size_t i = 1; i < reactors_.size(); i++)
+    {
+        Reactor *reactor = reactors_[i].get();
+        reactor->thread = std::thread(&WebServer::loop_, this, reactor);
+    }
+    // 主线程运行0号Reactor
+    loop_(reactors_[0].get());
+    // 主Reactor退出（收到关闭信号），唤醒其余Reactor并等待其退出
+    for (size_t i = 1; i < reactors_.size(); i++)
+    {
+        Reactor *reactor = reactors_[i].get();
+        if (reactor->thread.joinable())
+        {
+            wakeup_(reactor);
+            reactor->thread.join();
+        }
+    }
+    LOG_INFO("ThreadPool Queue: %zu, Peak: %zu, Rejected: %llu, Dropped: %llu, Caller Runs: %llu, CoDel Shed: %llu",
+             threadPool_->queueSize(), threadPool_->peakQueueSize(),
+             (unsigned long long)threadPool_->rejectCount(), (unsigned long long)threadPool_->dropCount(),
+             (unsigned long long)threadPool_->callerRunsCount(), (unsigned long long)threadPool_->shedCount());
+    LOG_INFO("ThreadPool Threads: %zu, Grown: %llu, Shrunk: %llu", threadPool_->threadCount(),
+             (unsigned long long)threadPool_->growCount(), (unsigned long long)threadPool_->shrinkCount());
+    if (dbPool_)
+    {
+        LOG_INFO("DB ThreadPool Queue: %zu, Peak: %zu, Rejected: %llu, Dropped: %llu, Caller Runs: %llu",
+                 dbPool_->queueSize(), dbPool_->peakQueueSize(),
+                 (unsigned long long)dbPool_->rejectCount(), (unsigned long long)dbPool_->dropCount(),
+                 (unsigned long long)dbPool_->callerRunsCount());
+    }
+}
+
+/*
+ * 运行reactor的事件循环
+ */
+void WebServer::loop_(Reactor *reactor)
+{
+    assert(reactor);
+    // epoll wait timeout == -1 无事件将阻塞
+    // 如果timeout大于0时才会设置超时信号，后面可以改为根据最接近的超时事件设置超时时长
+    int timeMS = -1;
 
     // 根据不同的事件调用不同的函数
     while (!isClose_)
@@ -533,46 +1150,69 @@ void WebServer::start()
         if (timeoutMS_ > 0)
         {
             // 获取最近的超时时间，同时删除超时节点
-            timeMS = timer_->getNextTick();
+            timeMS = reactor->timer->getNextTick();
         }
         // epoll等待事件的唤醒，等待时间为最近一个连接会超时的时间
         // 第一次调用是阻塞的（timeMS为-1），接下来每次调用timeMS为定时器小根堆顶的超时时长，也就是最小超时时间
         // 返回0说明超时，不会调用下面的for循环
-        int eventCount = epoller_->wait(timeMS);
+        // 监听队列中还有没accept完的连接时不阻塞
+        bool listened = false;
+        int eventCount = reactor->epoller->wait(reactor->acceptPending ? 0 : timeMS);
+        // 每轮只取一次当前时间，本轮所有读写事件和下一轮的超时检查都使用这个值
+        if (lazyTimer_)
+        {
+            reactor->now = Clock::now();
+        }
         for (int i = 0; i < eventCount; i++)
         {
             // 获取对应文件描述符与epoll事件
-            int fd = epoller_->getEventFd(i);
-            uint32_t events = epoller_->getEvents(i);
+            int fd = reactor->epoller->getEventFd(i);
+            uint32_t events = reactor->epoller->getEvents(i);
 
             // 根据不同情况进入不同分支
             // 若对应文件描述符为监听描述符，进入新连接处理流程
-            if (fd == listenFd_)
+            if (fd == reactor->listenFd)
             {
-                dealListen_();
+                listened = true;
+                dealListen_(reactor);
             }
-            // 若epoll事件为 (EPOLLRDHUP | EPOLLHUP | EPOLLERR) 其中之一，表示连接出现问题，需要关闭该连接
-            else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            // 若对应文件描述符为唤醒描述符，读出计数，回到循环开头检查是否需要退出
+            else if (fd == reactor->wakeupFd)
             {
-                assert(users_.count(fd) > 0);
-                closeConn_(&users_[fd]);
+                dealWakeup_(reactor);
             }
             // 若epoll事件为EPOLLIN并且fd是信号管道，表示有信号需要处理
-            else if (fd == pipefd_[0] && (events & EPOLLIN))
+            else if (reactor->id == 0 && fd == pipefd_[0] && (events & EPOLLIN))
             {
                 dealSignal_();
             }
+            // 若epoll事件为 (EPOLLRDHUP | EPOLLHUP | EPOLLERR) 其中之一，表示连接出现问题，需要关闭该连接
+            else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            {
+                HttpConn *client = users_.find(fd);
+                assert(client);
+                dealClose_(reactor, client);
+            }
+            // 单所有者模式下读写事件统一交给连接的所有者处理
+            else if (singleOwner_)
+            {
+                HttpConn *client = users_.find(fd);
+                assert(client);
+                dealEvent_(reactor, client, events);
+            }
             // 若epoll事件为EPOLLIN，表示有对应套接字收到数据，需要读取出来
             else if (events & EPOLLIN)
             {
-                assert(users_.count(fd) > 0);
-                dealRead_(&users_[fd]);
+                HttpConn *client = users_.find(fd);
+                assert(client);
+                dealRead_(reactor, client);
             }
             // 若epoll事件为EPOLLOUT，表示返回给客户端的数据已准备好，需要向对应套接字连接发送数据
             else if (events & EPOLLOUT)
             {
-                assert(users_.count(fd) > 0);
-                dealWrite_(&users_[fd]);
+                HttpConn *client = users_.find(fd);
+                assert(client);
+                dealWrite_(reactor, client);
             }
             // 其余事件皆为错误，向log文件写入该事件
             else
@@ -580,5 +1220,18 @@ void WebServer::start()
                 LOG_ERROR("Unexpected Event!");
             }
         }
+        // 本轮事件处理完之后再关闭工作线程请求关闭的连接
+        dealPendingClose_(reactor);
+        // ET模式下上一次accept用完了批量上限，不会再有新的监听事件，处理完本轮读写事件后继续accept
+        if (reactor->acceptPending && !listened)
+        {
+            dealListen_(reactor);
+        }
+    }
+    if (reactor->listenFd >= 0)
+    {
+        LOG_INFO("Reactor[%d] Accept: %llu, Overflow: %llu, Batch Full: %llu", reactor->id,
+                 (unsigned long long)reactor->acceptCount, (unsigned long long)reactor->overflowCount,
+                 (unsigned long long)reactor->batchFullCount);
     }
 }
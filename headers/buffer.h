@@ -18,6 +18,8 @@
 #include <unistd.h>  // write
 #include <sys/uio.h> // readv
 
+#include "simdscan.h"
+
 class Buffer
 {
 public:
@@ -35,6 +37,8 @@ public:
 
     // 返回当前readPos_所在字符地址的指针
     const char *peek() const;
+    // 返回当前readPos_所在字符地址的指针，可以原地修改可读数据（比如去掉分块传输编码的格式）
+    char *beginRead();
     // 移动readPos_指针，读了len个字节的数据
     void retrieve(size_t len);
     // 移动readPos_指针，移动大小为readPos_所在字符地址的指针到end这一段
@@ -43,11 +47,17 @@ public:
     void retrieveAll();
     // 以string类型返回被回收的数据，同时回收所有空间
     std::string retrieveAllToStr();
+    // 在可读数据中查找CRLF，返回\r的位置，没有找到时返回nullptr
+    const char *findCRLF() const;
+    // 从start开始查找CRLF
+    const char *findCRLF(const char *start) const;
 
     // 确保还能写len个字节，如果不能，再开辟len大小的可写空间
     void ensureWritable(size_t len);
     // 写了len个字节的数据，移动writePos_位置
     void hasWritten(size_t len);
+    // 撤销最后写入的len个字节，writePos_往回移动（原地删除可读数据中的一段后缩短可读数据）
+    void unwrite(size_t len);
     // 返回可以写的缓冲区的第一个位置const
     const char *beginWriteConst() const;
     // 返回可以写的缓冲区的第一个位置
@@ -0,0 +1,76 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 19:05:41
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 19:05:41
+ */
+#ifndef CHUNKED_H
+#define CHUNKED_H
+
+#include <string>
+#include <string.h> // memmove
+#include <stdint.h>
+#include <algorithm> // min
+
+#include "log.h"
+#include "buffer.h"
+#include "simdscan.h"
+
+/*
+ * 流式分块传输编码（Transfer-Encoding: chunked）解码器（RFC 7230 4.1）
+ * 在调用者的读缓冲区中原地解码：去掉分块大小行和分块后的CRLF，解码后的数据连续保存在缓冲区开头，
+ * 调用者像处理Content-Length请求体一样处理这部分数据，没处理完的部分留在缓冲区开头，和之后解码的数据拼在一起
+ * 不完整的分块大小行留在缓冲区中，下次和新数据一起解析，请求体不需要整体保存在内存中
+ * 尾部字段（trailer）原样保存，由调用者合并到请求头中
+ */
+class ChunkedDecoder
+{
+public:
+    // 构造函数
+    ChunkedDecoder();
+    // 开始解码一个请求体
+    void init();
+    // 解码buff中新到达的数据，解码后的数据在buff开头（decoded()字节），返回false表示格式错误
+    bool decode(Buffer &buff);
+    // buff开头已经解码、调用者还没有处理的数据长度
+    size_t decoded() const;
+    // 调用者处理并回收了buff开头len字节解码后的数据
+    void consume(size_t len);
+    // 是否已经读到最后一个分块和尾部字段的结尾
+    bool finished() const;
+    // 已经解码的请求体总长度
+    size_t total() const;
+    // 尾部字段，每行以CRLF结尾，不包括结尾的空行
+    const std::string &trailer() const;
+
+private:
+    // 解码状态
+    enum STATE
+    {
+        SIZE,      // 分块大小行（可以带分块扩展）
+        DATA,      // 分块数据
+        DATA_CRLF, // 分块数据之后的CRLF
+        TRAILER,   // 最后一个分块（大小为0）之后的尾部字段，到空行为止
+        DONE,      // 解码完成
+        FAILED     // 格式错误
+    };
+
+    // 解析分块大小行[begin, end)，十六进制的大小之后可以有;开始的分块扩展（忽略）
+    bool parseSize_(const char *begin, const char *end);
+    // 格式错误
+    void fail_(const char *reason);
+
+    static const size_t MAX_SIZE_LINE = 1024; // 分块大小行（包括分块扩展）的长度上限
+    static const size_t MAX_TRAILER = 8192;   // 尾部字段的长度上限
+
+    STATE state_;         // 解码状态
+    size_t left_;         // 当前分块还没有读到的数据长度
+    size_t decoded_;      // buff开头已经解码、调用者还没有处理的数据长度
+    size_t total_;        // 已经解码的请求体总长度
+    std::string trailer_; // 尾部字段
+};
+
+#endif // CHUNKED_H
@@ -45,6 +45,22 @@ public:
     int logQueSize;      // 阻塞队列容量
     int actor;           // 事件处理模式默认为reactor
     bool is_daemon;      // 是否开启守护进程
+    int reactorMode;     // 事件循环模式：单Reactor(0)/多Reactor+SO_REUSEPORT(1)/主从Reactor(2)
+    int reactorNum;      // Reactor（事件循环线程）数量，0表示与CPU核数相同，主从模式下为子Reactor数量
+    int balance;         // 主从Reactor模式下新连接分配策略：轮询(0)/最少连接(1)
+    int ioBackend;       // 事件后端：epoll(0)/io_uring(1)/io_uring+SQPOLL(2)
+    int backlog;         // 监听队列长度，0表示使用系统的somaxconn
+    int acceptBatch;     // 每次监听事件最多accept的连接数，0表示不限制
+    int timerType;       // 定时器：小根堆(0)/分层时间轮(1)
+    bool lazyTimer;      // 惰性定时器：读写事件只记录活动时间，定时器到期时再检查并重新调度
+    int poolMode;        // 线程池调度模式：共享队列(0)/工作窃取(1)/按fd亲和(2)/无锁队列(3)
+    int maxTasks;        // 线程池任务队列的最大长度，0表示不限制
+    int rejectPolicy;    // 任务队列已满时的拒绝策略：拒绝(0)/调用者执行(1)/丢弃最早的任务(2)
+    int codelTarget;     // CoDel准入控制的目标排队时间（毫秒），0表示关闭
+    int codelInterval;   // CoDel准入控制的观察区间（毫秒）
+    int dbThreadNum;     // 数据库线程池数量（处理登录、注册请求），0表示在工作线程中直接访问数据库
+    bool pinCpu;         // 是否把工作线程绑定到CPU上
+    int maxThreadNum;    // 线程池数量上限，大于threadNum时共享队列模式下线程数按负载动态调整，0表示固定为threadNum
 };
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -10,6 +10,7 @@
 #ifndef EPOLLER_H
 #define EPOLLER_H
 
+#include <memory>
 #include <vector>
 #include <fcntl.h> // fcntl
 #include <errno.h>
@@ -17,11 +18,21 @@
 #include <assert.h>    // close()
 #include <sys/epoll.h> //epoll_ctl()
 
+#include "uringpoller.h"
+
 class Epoller
 {
 public:
-    // 构造函数，创建epoll内核事件表和初始化就绪事件数组
-    explicit Epoller(int maxEvent = 1024);
+    // 事件后端
+    enum BACKEND
+    {
+        EPOLL = 0,    // epoll_wait/epoll_ctl
+        URING,        // io_uring poll，创建失败时回退到epoll
+        URING_SQPOLL, // io_uring poll并尝试开启SQPOLL（内核线程轮询提交队列），开启失败时使用普通io_uring
+    };
+
+    // 构造函数，创建epoll内核事件表（或io_uring实例）和初始化就绪事件数组
+    explicit Epoller(int maxEvent = 1024, BACKEND backend = EPOLL);
     // 析构函数
     ~Epoller();
     // 注册事件
@@ -36,9 +47,12 @@ public:
     int getEventFd(size_t i) const;
     // 获取第i个事件的事件类型
     uint32_t getEvents(size_t i) const;
+    // 获取实际使用的事件后端
+    BACKEND backend() const;
 
 private:
-    int epollFd_;                            // epoll_create()创建的epoll文件描述符
+    int epollFd_;                            // epoll_create()创建的epoll文件描述符，使用io_uring后端时为-1
+    std::unique_ptr<UringPoller> uring_;     // io_uring后端，为空时使用epoll
     std::vector<struct epoll_event> events_; // epoll就绪事件数组
 };
 
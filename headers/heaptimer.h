@@ -2,20 +2,14 @@
 #define HEAP_TIMER_H
 
 #include <queue>
-#include <chrono>
 #include <algorithm>
-#include <functional>
 #include <unordered_map>
 #include <time.h>
 #include <assert.h>
 #include <arpa/inet.h>
 
 #include "log.h"
-
-typedef std::function<void()> TimeoutCallBack;    // 定义的functional对象，接受一个bind函数绑定的函数对象
-typedef std::chrono::high_resolution_clock Clock; // 获取时间的类
-typedef std::chrono::milliseconds MS;             // 毫秒
-typedef Clock::time_point TimeStamp;              // 时间戳
+#include "timer.h"
 
 /*
  * 定义的绑定文件描述符，超时时间，删除函数的结构体
@@ -33,7 +27,7 @@ struct TimerNode
     }
 };
 
-class HeapTimer
+class HeapTimer : public Timer
 {
 public:
     // 构造函数，预申请一些空间
@@ -41,19 +35,21 @@ public:
     // 析构函数，清空空间
     ~HeapTimer();
     // 调整文件描述符id关联的定时器的过期时间为：当前时间+timeout，并下移调整堆
-    void adjust(int id, int newExpires);
+    void adjust(int id, int newExpires) override;
     // 将指定文件描述符id添加一个定时器到堆中，超时时间为timeout，回调函数为cb
-    void add(int id, int timeout, const TimeoutCallBack &cb);
+    void add(int id, int timeout, const TimeoutCallBack &cb) override;
     // 删除指定id结点，并触发回调函数（未使用）
-    void doWork(int id);
+    void doWork(int id) override;
+    // 删除指定id结点，不触发回调函数
+    void cancel(int id) override;
     // 清空堆中的元素
-    void clear();
+    void clear() override;
     // 删除堆中所有的超时节点，并触发它们的回调函数
-    void tick();
+    void tick() override;
     // 删除堆中的第一个节点
     void pop();
     // 删除所有超时节点，返回最近一个超时节点的超时时间
-    int getNextTick();
+    int getNextTick() override;
 
 private:
     // 删除堆中的指定index节点
@@ -1,6 +1,8 @@
 #ifndef HTTP_CONN_H
 #define HTTP_CONN_H
 
+#include <atomic>
+#include <algorithm> // std::min
 #include <errno.h>
 #include <stdlib.h>    // atoi()
 #include <sys/uio.h>   // readv/writev
@@ -8,6 +10,7 @@
 #include <sys/types.h>
 
 #include "log.h"
+#include "timer.h"
 #include "buffer.h"
 #include "sqlconnRAII.h"
 #include "httprequest.h"
@@ -16,6 +19,14 @@
 class HttpConn
 {
 public:
+    // 单所有者模式下记录的连接事件
+    enum CONN_EVENT
+    {
+        READABLE = 1 << 0, // 有数据可读
+        WRITABLE = 1 << 1, // 发送缓冲区可写
+        CLOSE = 1 << 2,    // 需要关闭（出错、对端关闭或超时）
+    };
+
     // 构造函数
     HttpConn();
     // 析构函数
@@ -25,19 +36,39 @@ public:
     // 读写数据
     ssize_t read(int *saveErrno);
     ssize_t write(int *saveErrno);
+    // 上一次read是否因为读缓冲区达到上限而停止（ET模式下socket中可能还有数据）
+    bool readPaused() const;
     // 关闭该连接
     void close();
+    // 该连接是否已经关闭
+    bool isClosed() const;
     // 获取该连接的信息
     int getFd() const;
     int getPort() const;
     const char *getIP() const;
     sockaddr_in getAddr() const;
-    // 解析请求并生成响应
+    // 解析读缓冲区中所有完整的请求并依次生成响应，返回是否有待发送的响应
     bool process();
+    // 读缓冲区中是否还有没处理的请求数据，或者有等待验证的请求
+    bool hasPendingRequest() const;
+    // 解析完成的请求是否需要访问数据库（process返回false时检查）
+    bool needsVerify() const;
+    // 访问数据库完成用户验证，并生成响应
+    void verify();
     // 返回需要写的数据长度
     int toWriteBytes();
     // 返回是否长连接
     bool isKeepAlive() const;
+    // 惰性定时器模式：记录最近一次活动的时间
+    void setLastActive(TimeStamp now);
+    // 惰性定时器模式：返回最近一次活动的时间
+    TimeStamp getLastActive() const;
+    // 单所有者模式：记录就绪事件，返回true表示调用者获得了该连接的所有权，需要调度任务处理
+    bool postEvents(uint32_t events);
+    // 单所有者模式：所有者取出待处理的事件
+    uint32_t takeEvents();
+    // 单所有者模式：所有者尝试释放所有权，期间有新事件到达时返回false，所有者需要继续处理
+    bool releaseOwner();
     // 静态成员
     static bool isET;                  // 指示工作模式
     static const char *srcDir;         // 资源文件目录
@@ -45,13 +76,43 @@ public:
     static std::atomic<int> userCount; // 指示用户连接个数，原子变量，各连接共享
 
 private:
+    // 根据状态码生成响应，加入待发送队列
+    void makeResponse_(int code);
+    // 调用动态路由的处理函数生成响应，加入待发送队列
+    void routeResponse_();
+    // 发送完成的响应出队，解除文件映射
+    void popResponse_();
+
+    static const uint32_t OWNED = 1u << 31;            // 所有权标志位，置位表示有线程正在处理该连接
+    static const int MAX_PIPELINE = 16;                // 一个连接上排队等待发送的响应数上限
+    static const size_t MAX_READ_BUFFER = 1024 * 1024; // ET模式下一次read最多读到读缓冲区有这么多数据
+
+    // 待发送的响应，响应头按顺序连续保存在writeBuff_中，响应体是各自的文件内存映射
+    // 动态路由的响应体由处理函数直接写在响应头之后，也计入headLen，没有文件内存映射
+    struct Response
+    {
+        size_t headLen;   // 响应头还没发送的长度
+        char *file;       // 响应体还没发送部分的起始位置
+        size_t fileLen;   // 响应体还没发送的长度
+        char *mmFile;     // 文件内存映射的地址，发送完成后解除映射
+        size_t mmFileLen; // 文件内存映射的长度
+    };
+
     int fd_;                  // socket对应的文件描述符
     bool isClose_;            // 指示工作状态，该连接是否关闭
+    bool readPaused_;         // 上一次read是否因为读缓冲区达到上限而停止
     struct sockaddr_in addr_; // 客户端socket对应的地址
+    // note: 低位为待处理的CONN_EVENT，最高位为所有权标志，Reactor与工作线程通过原子操作交接
+    std::atomic<uint32_t> events_;
+    TimeStamp lastActive_; // 最近一次活动的时间，惰性定时器模式下只由Reactor线程读写
 
-    // 缓冲区块
-    int iovCnt_;          // 输出数据的个数，不在连续区域
-    struct iovec iov_[2]; // 代表输出哪些数据的结构体
+    // note: 流水线（pipelining）请求的响应按请求顺序排队，write时所有响应用一次writev聚集写
+    Response responses_[MAX_PIPELINE];   // 待发送响应的环形队列
+    int responseHead_;                   // 队头下标
+    int responseCnt_;                    // 队列中的响应个数
+    size_t toWrite_;                     // 所有待发送响应的总长度
+    bool isKeepAlive_;                   // 最后一个入队的响应是否保持长连接
+    struct iovec iov_[MAX_PIPELINE * 2]; // writev的缓冲区，每个响应一个响应头和一个响应体
 
     Buffer readBuff_;  // 读缓冲区，保存请求数据
     Buffer writeBuff_; // 写缓冲区，保存相应数据
@@ -10,20 +10,28 @@
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
-#include <regex>
 #include <string>
+#include <algorithm> // std::min
+#include <stdint.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <errno.h>
 #include <mysql/mysql.h> //mysql
 
 #include "log.h"
 #include "buffer.h"
+#include "chunked.h"
+#include "multipart.h"
+#include "router.h"
+#include "routetable.h"
+#include "stringview.h"
 #include "sqlconnpoll.h"
 #include "sqlconnRAII.h"
 
 class HttpRequest
 {
+    // 处理函数通过RequestView读取请求首行、请求体和路径参数
+    friend class RequestView;
+
 public:
     // 指示解析到请求头的哪一部分的枚举变量
     enum PARSE_STATE
@@ -64,8 +72,20 @@ public:
     // 返回请求头中指定key对应的数据
     std::string getPost(const std::string &key) const;
     std::string getPost(const char *key) const;
+    // 返回请求头中指定字段（不区分大小写）的值，没有该字段时返回空切片，请求头解析完成后到下一次init前有效
+    StringView header(const StringView &name) const;
     // 是否是长连接
     bool isKeepAlive() const;
+    // 匹配的动态路由，没有匹配时handler为nullptr，解析完成后由调用者调用处理函数
+    const RouteMatch &route() const;
+    // 是否是需要访问数据库的请求（登录或注册），解析完成后由调用者调度verify
+    bool needsVerify() const;
+    // 访问数据库进行用户验证，根据结果设置返回的页面（可能阻塞）
+    void verify();
+    // 是否可以把socket中的数据直接splice到上传文件：buff中没有处理的数据都属于正在写的文件，并且剩下的请求体足够长
+    bool canSplice(const Buffer &buff) const;
+    // 把socket中的上传文件内容直接splice到文件，返回值同Buffer::readFd，需要继续解析的数据放回buff
+    ssize_t splice(int sockFd, Buffer &buff, int *saveErrno);
 
     // 静态常量
     // note: 注意，这里的需要是静态的，并且需要在在全局定义，在外层调用构造的时候初始化
@@ -76,37 +96,76 @@ private:
     static int convertHex(char ch);
     // 用户验证（登陆或注册）
     static bool userVerify(const std::string &name, const std::string &pwd, bool isLogin);
-    // 解析HTTP请求首行
-    bool parseRequestLine_(const std::string &line);
-    // 解析HTTP请求头
-    void parseHeader_(const std::string &line);
-    // 解析HTTP消息体
-    bool parseBody_(const std::string &line);
-    // 解析资源路径，并将路径添加完整
+    // 增量解析请求首行和请求头，直到遇到空行
+    HTTP_CODE parseHeaders_(Buffer &buff);
+    // 解析HTTP请求首行，[begin, end)为去掉CRLF的一行
+    bool parseRequestLine_(const char *begin, const char *end);
+    // 解析HTTP请求头的一行，offset为该行相对请求起始位置的偏移
+    bool parseHeader_(const char *begin, const char *end, size_t offset);
+    // 请求头字段name出现的次数，value为第一次出现时的值
+    size_t headerCount_(const StringView &name, StringView &value) const;
+    // 请求头解析完成后，根据Content-Length和Content-Type准备解析请求体
+    bool initBody_();
+    // 处理一段请求体数据，返回处理掉的长度（可能小于len，剩下的数据等更多数据到达后再处理），last表示数据到请求体结尾为止
+    size_t parseBody_(const char *data, size_t len, bool last);
+    // 分块传输编码的请求体：解码缓冲区中的数据后交给parseBody_
+    HTTP_CODE parseChunkedBody_(Buffer &buff);
+    // 把分块传输编码的尾部字段合并到请求头中
+    bool parseTrailer_();
+    // 请求体接收完成，根据请求体类型完成请求
+    HTTP_CODE finishBody_();
+    // 在路由表中查找请求路径，页面别名替换为实际的文件路径
     void parsePath_();
-    // 解析POST消息体
-    bool parsePost_();
     // 解析form-urlencoded格式，获取POST的数据
-    void parseFromUrlencoded_();
-    // 解析multipart/form-data格式，获取POST的数据（上传文件）
-    bool parseFormData_();
+    void parseFromUrlencoded_(const StringView &body);
+
+    static const size_t MAX_HEADERS = 64;             // 请求头字段数上限
+    static const size_t MAX_HEADER_SIZE = 8192 * 8;    // 请求首行加请求头的长度上限
+    static const size_t MAX_FORM_SIZE = 8192 * 8;      // form-urlencoded请求体的长度上限
+    static const size_t MAX_UPLOAD_SIZE = 4ull << 30;  // 上传文件请求体的长度上限
+    static const size_t SPLICE_MIN = 256 * 1024;       // 剩下的请求体超过这么多才改为splice
+    static const size_t SPLICE_TAIL = 4096;            // 请求体最后这么多数据（结束分隔行）仍然读到缓冲区中解析
+
+    // 请求体类型
+    enum BODY_TYPE
+    {
+        BODY_OTHER,      // 其他类型，读完后丢弃
+        BODY_URLENCODED, // application/x-www-form-urlencoded，登录和注册
+        BODY_FORM_DATA,  // multipart/form-data，上传文件
+        BODY_ROUTE       // 动态路由的请求体，整体保存到body_中交给处理函数
+    };
 
-    PARSE_STATE state_;                                   // 状态机解析状态
-    std::string method_, path_, version_, body_;          // 请求首行：方法、URL、版本，消息体
-    std::unordered_map<std::string, std::string> header_; // 请求头字段hashmap，key:value对形式
+    // 请求头字段，以相对请求起始位置的偏移记录，缓冲区扩容搬移数据后仍然有效
+    struct HeaderField
+    {
+        uint32_t name;     // 字段名偏移
+        uint32_t nameLen;  // 字段名长度
+        uint32_t value;    // 字段值偏移
+        uint32_t valueLen; // 字段值长度
+    };
+
+    PARSE_STATE state_;                          // 状态机解析状态
+    std::string method_, path_, version_, body_; // 请求首行：方法、URL、版本，分多次到达的form-urlencoded请求体或者动态路由的请求体
+    // note: 以下成员在init时只清空不释放内存，长连接上后续的请求复用已分配的容量
+    std::string raw_;                        // 请求首行和请求头的原始数据，请求头字段的切片指向这里
+    HeaderField headers_[MAX_HEADERS];       // 请求头字段
+    size_t headerCnt_;                       // 请求头字段数
+    size_t scanned_;                         // 缓冲区中已经扫描过的完整行的长度，数据不完整时下次从这里继续
     // POST请求表单中的信息，以key:value对的形式存储POST的参数（用户名&密码）
     // 因为本服务器接受的是application/x-www-form-urlencoded这种表单形式
     std::unordered_map<std::string, std::string> post_;
 
-    int parseBodyCnt_;           // 解析了几行请求内容
-    std::string uploadFilename_; // 上传的文件名
-    FILE *fp_;                   // 文件指针
-    bool upload_;                // 是否上传文件
+    BODY_TYPE bodyType_;         // 请求体类型
+    size_t contentLength_;       // 请求体长度（Content-Length）
+    size_t bodyRead_;            // 已经读取的请求体长度，请求体到Content-Length为止，之后是流水线上的下一个请求
+    bool isChunked_;             // 请求体是否是分块传输编码（Transfer-Encoding: chunked），此时没有Content-Length
+    ChunkedDecoder chunked_;     // 分块传输编码的解码器
+    MultipartParser multipart_;  // 上传文件请求体的解析器
     bool upload_error_;          // 上传文件错误指示
-
-    // 静态常量
-    static const std::unordered_set<std::string> DEFAULT_HTML;          // 默认的返回页面的地址
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG; // 保存默认的HTML标签
+    bool verify_;                // 是否需要进行用户验证（访问数据库）
+    bool isLogin_;               // 用户验证的类型：登录(true)/注册(false)
+    const RouteTable::Route *route_; // 请求路径对应的路由，没有注册时为nullptr
+    RouteMatch match_;               // 匹配的动态路由和路径参数
 };
 
 #endif // HTTP_REQUEST_H
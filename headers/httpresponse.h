@@ -35,6 +35,8 @@ public:
     void unmapFile();
     // 获取文件的内存映射地址
     char *file();
+    // 交出文件的内存映射，之后由调用者负责解除映射
+    char *releaseFile();
     // 获取文件大小
     size_t fileLen() const;
     // 添加错误内容
@@ -0,0 +1,377 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 16:21:07
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 16:21:07
+ */
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/*
+ * 事件计数器，让线程在某个条件上无锁地休眠和唤醒（futex实现）
+ * 等待方：prepareWait() -> 再检查一次条件 -> 条件满足则cancelWait()，否则wait()
+ * 通知方：先让条件成立，再调用notifyOne/notifyAll
+ * state_的低32位是准备等待的线程数，高32位是已发出还没被领取的信号数，信号数不超过等待线程数：
+ * 被唤醒的线程还没运行时再通知只会看到信号数已经等于等待线程数而直接返回，不会反复进入内核
+ * 没有线程等待时通知只是一次内存屏障加一次读
+ */
+class EventCount
+{
+public:
+    // 构造函数
+    EventCount() : state_(0), epoch_(0) {}
+    // 准备等待，之后必须调用cancelWait或wait
+    void prepareWait()
+    {
+        state_.fetch_add(1, std::memory_order_seq_cst);
+        // 与通知方的屏障配对，保证要么等待方再检查条件时看到条件成立，要么通知方看到等待方
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    // 取消等待，信号数等于等待线程数时说明信号可能是发给自己的，一并收回
+    void cancelWait()
+    {
+        uint64_t state = state_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do
+        {
+            next = state - 1;
+            if ((state >> 32) == (state & WAITER_MASK))
+            {
+                next -= SIGNAL;
+            }
+        } while (!state_.compare_exchange_weak(state, next, std::memory_order_relaxed));
+    }
+    // 休眠直到领取到一个信号
+    void wait()
+    {
+        while (true)
+        {
+            // 先读纪元再读信号，通知方在两次读之间发出信号时纪元已经变化，futex不会休眠
+            uint32_t epoch = epoch_.load(std::memory_order_acquire);
+            uint64_t state = state_.load(std::memory_order_acquire);
+            while ((state >> 32) > 0)
+            {
+                if (state_.compare_exchange_weak(state, state - SIGNAL - 1, std::memory_order_acquire))
+                {
+                    return;
+                }
+            }
+            futex_(FUTEX_WAIT_PRIVATE, epoch);
+        }
+    }
+    // 唤醒一个等待的线程
+    void notifyOne()
+    {
+        notify_(false);
+    }
+    // 唤醒所有等待的线程
+    void notifyAll()
+    {
+        notify_(true);
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+    static const uint64_t WAITER_MASK = 0xffffffffull; // 等待线程数的掩码
+    static const uint64_t SIGNAL = 1ull << 32;         // 一个信号
+
+    // 发出信号并唤醒线程，所有等待线程都已经有信号时直接返回
+    void notify_(bool all)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t state = state_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do
+        {
+            uint64_t waiters = state & WAITER_MASK;
+            uint64_t signals = state >> 32;
+            if (signals >= waiters)
+            {
+                return;
+            }
+            next = all ? (waiters << 32) | waiters : state + SIGNAL;
+        } while (!state_.compare_exchange_weak(state, next, std::memory_order_seq_cst, std::memory_order_relaxed));
+        epoch_.fetch_add(1, std::memory_order_release);
+        futex_(FUTEX_WAKE_PRIVATE, all ? INT32_MAX : 1);
+    }
+
+    // futex系统调用
+    long futex_(int op, uint32_t val)
+    {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch_), op, val, nullptr, nullptr, 0);
+    }
+
+    std::atomic<uint64_t> state_;   // 等待线程数和信号数
+    std::atomic<uint32_t> epoch_;   // 纪元，每次发出信号加1，等待的线程休眠在这个字上
+};
+
+/*
+ * 无锁多生产者多消费者有界环形队列（Dmitry Vyukov算法）
+ * 每个槽带一个序号：序号等于写下标时可写，等于写下标+1时可读，生产者和消费者各自用CAS抢占下标，
+ * 抢到后独占该槽读写数据，再用release写序号把槽交给对方，所以元素本身不需要是原子的
+ * 容量为2的幂，tryPush/tryPop不阻塞，push/pop在队列满/空时先短暂自旋再通过EventCount休眠
+ * close之后push失败，pop取完剩余元素后返回false
+ */
+template <class T>
+class MpmcQueue
+{
+public:
+    // 构造函数，容量向上取整为2的幂
+    explicit MpmcQueue(size_t capacity = 1024);
+    // 默认析构函数
+    ~MpmcQueue() = default;
+    // 向队尾加入一个元素，队列满或已关闭时返回false
+    bool tryPush(const T &item);
+    // 从队头弹出一个元素，队列空时返回false
+    bool tryPop(T &item);
+    // 向队尾加入一个元素，队列满时休眠等待，已关闭时返回false
+    bool push(const T &item);
+    // 从队头弹出一个元素，队列空时休眠等待，已关闭并且队列为空时返回false
+    bool pop(T &item);
+    // 关闭队列，唤醒所有等待的线程
+    void close();
+    // 是否已关闭
+    bool closed() const;
+    // 队列中元素个数（近似值）
+    size_t size() const;
+    // 队列容量
+    size_t capacity() const;
+
+private:
+    static const int SPIN_COUNT = 16; // push/pop休眠前的自旋次数
+
+    // 槽
+    struct Slot
+    {
+        std::atomic<size_t> seq; // 序号
+        T data;                  // 元素
+    };
+
+    std::unique_ptr<Slot[]> slots_; // 环形缓冲区
+    size_t mask_;                   // 下标掩码，容量-1
+    std::atomic<bool> closed_;      // 是否已关闭
+    EventCount notEmpty_;           // 消费者等待队列非空
+    EventCount notFull_;            // 生产者等待队列不满
+    // note: 读写下标之间填充一个缓存行，避免生产者和消费者之间的伪共享
+    char pad0_[64];            // 缓存行填充
+    std::atomic<size_t> tail_; // 写下标，生产者CAS竞争
+    char pad1_[64];            // 缓存行填充
+    std::atomic<size_t> head_; // 读下标，消费者CAS竞争
+    char pad2_[64];            // 缓存行填充
+};
+
+/*
+ * 构造函数，容量向上取整为2的幂，第i个槽的序号初始化为i
+ */
+template <class T>
+MpmcQueue<T>::MpmcQueue(size_t capacity) : closed_(false), tail_(0), head_(0)
+{
+    assert(capacity > 0);
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    slots_.reset(new Slot[size]);
+    for (size_t i = 0; i < size; i++)
+    {
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+}
+
+/*
+ * 向队尾加入一个元素，队列满或已关闭时返回false
+ */
+template <class T>
+bool MpmcQueue<T>::tryPush(const T &item)
+{
+    if (closed_.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true)
+    {
+        slot = &slots_[pos & mask_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        // 槽空闲，抢占写下标
+        if (diff == 0)
+        {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        // 槽中的元素还没被取走（绕了一圈），队列满
+        else if (diff < 0)
+        {
+            return false;
+        }
+        // 其他生产者已经抢走了这个下标，重新读
+        else
+        {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->data = item;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    notEmpty_.notifyOne();
+    return true;
+}
+
+/*
+ * 从队头弹出一个元素，队列空时返回false
+ */
+template <class T>
+bool MpmcQueue<T>::tryPop(T &item)
+{
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true)
+    {
+        slot = &slots_[pos & mask_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        // 槽中有元素，抢占读下标
+        if (diff == 0)
+        {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        // 槽还没写入，队列空
+        else if (diff < 0)
+        {
+            return false;
+        }
+        // 其他消费者已经抢走了这个下标，重新读
+        else
+        {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+    item = slot->data;
+    // 序号加上容量，留给下一圈的生产者
+    slot->seq.store(pos + mask_ + 1, std::memory_order_release);
+    notFull_.notifyOne();
+    return true;
+}
+
+/*
+ * 向队尾加入一个元素，队列满时休眠等待，已关闭时返回false
+ */
+template <class T>
+bool MpmcQueue<T>::push(const T &item)
+{
+    for (int i = 0; i < SPIN_COUNT; i++)
+    {
+        if (tryPush(item))
+        {
+            return true;
+        }
+    }
+    while (true)
+    {
+        notFull_.prepareWait();
+        if (tryPush(item))
+        {
+            notFull_.cancelWait();
+            return true;
+        }
+        if (closed_.load(std::memory_order_acquire))
+        {
+            notFull_.cancelWait();
+            return false;
+        }
+        notFull_.wait();
+    }
+}
+
+/*
+ * 从队头弹出一个元素，队列空时休眠等待，已关闭并且队列为空时返回false
+ */
+template <class T>
+bool MpmcQueue<T>::pop(T &item)
+{
+    for (int i = 0; i < SPIN_COUNT; i++)
+    {
+        if (tryPop(item))
+        {
+            return true;
+        }
+    }
+    while (true)
+    {
+        notEmpty_.prepareWait();
+        if (tryPop(item))
+        {
+            notEmpty_.cancelWait();
+            return true;
+        }
+        if (closed_.load(std::memory_order_acquire))
+        {
+            notEmpty_.cancelWait();
+            // 关闭前最后一刻加入的元素
+            return tryPop(item);
+        }
+        notEmpty_.wait();
+    }
+}
+
+/*
+ * 关闭队列，唤醒所有等待的线程
+ */
+template <class T>
+void MpmcQueue<T>::close()
+{
+    closed_.store(true, std::memory_order_release);
+    notEmpty_.notifyAll();
+    notFull_.notifyAll();
+}
+
+/*
+ * 是否已关闭
+ */
+template <class T>
+bool MpmcQueue<T>::closed() const
+{
+    return closed_.load(std::memory_order_acquire);
+}
+
+/*
+ * 队列中元素个数（近似值）
+ */
+template <class T>
+size_t MpmcQueue<T>::size() const
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+/*
+ * 队列容量
+ */
+template <class T>
+size_t MpmcQueue<T>::capacity() const
+{
+    return mask_ + 1;
+}
+
+#endif // MPMC_QUEUE_H
@@ -0,0 +1,122 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 18:12:27
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 18:12:27
+ */
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <string>
+#include <algorithm> // min
+#include <errno.h>
+#include <fcntl.h>    // open, splice
+#include <unistd.h>   // write, close, unlink
+#include <sys/mman.h> // mmap, munmap
+
+#include "log.h"
+#include "buffer.h"
+#include "simdscan.h"
+#include "stringview.h"
+
+/*
+ * 流式multipart/form-data解析器（上传文件）
+ * 请求体分多次到达，每次把缓冲区中属于请求体的数据交给parse，解析器返回处理掉的长度，没处理的数据留在调用者的缓冲区中
+ * 这样跨数据包的分隔行和不完整的部分头都不需要解析器自己拷贝保存，内存占用与文件大小无关
+ * 文件数据是二进制安全的：只查找"\r\n--分隔符"，不按行处理，可以有多个部分，文件类型不限
+ * 文件内容直接从调用者的缓冲区write()到文件，攒够WRITE_SIZE再写，每次写的长度是页大小的整数倍
+ * 大文件的内容也可以不经过用户态缓冲区，由调用者通过splice接口从socket经管道直接移动到文件（见splice）
+ */
+class MultipartParser
+{
+public:
+    // 构造函数
+    MultipartParser();
+    // 析构函数，没有上传完的文件会被删除
+    ~MultipartParser();
+    // 开始解析一个请求体，dir为保存文件的目录（以/结尾），discard为true时只解析不保存（比如请求体超过大小限制）
+    void init(const StringView &boundary, const std::string &dir, bool discard);
+    // 中止解析，关闭并删除没有上传完的文件
+    void reset();
+    // 解析一段请求体数据，返回处理掉的长度，last表示数据到请求体结尾为止
+    size_t parse(const char *data, size_t len, bool last);
+    // 是否已经读到结束分隔行
+    bool finished() const;
+    // 是否有部分格式错误或者保存失败
+    bool error() const;
+    // 保存成功的文件数
+    int files() const;
+    // 当前是否在写文件内容，可以改为splice
+    bool canSplice() const;
+    // 开始或继续splice之前，把调用者缓冲区中还没处理的文件内容写入文件
+    void flush(const char *data, size_t len);
+    // 从socket经管道splice最多len字节到文件，返回从socket读取的长度，出错或没有数据时返回-1并设置saveErrno，对端关闭返回0
+    ssize_t splice(int sockFd, size_t len, int *saveErrno);
+    // 检查splice到文件的数据中有没有分隔行，有则截断文件，分隔行之后的数据追加到buff，返回追加的长度
+    size_t verify(Buffer &buff);
+    // 结束splice，文件末尾还没检查的数据（可能是分隔行的前缀）移回buff，返回移回的长度
+    size_t unsplice(Buffer &buff);
+    // 从形如 type; key1=value1; key2="value2" 的字段值中取出参数的值，没有该参数时返回空切片
+    static StringView param(const StringView &value, const StringView &name);
+
+private:
+    // 解析状态
+    enum STATE
+    {
+        PREAMBLE,        // 第一个分隔行之前的内容
+        DELIMITER_TAIL,  // 分隔行之后：--表示结束，否则到CRLF为止是下一个部分
+        PART_HEADER,     // 部分头
+        PART_DATA,       // 部分的内容
+        EPILOGUE,        // 结束分隔行之后的内容，忽略
+        FAILED           // 格式错误，忽略剩下的数据
+    };
+
+    // 各状态的处理函数，p为当前位置，返回false表示需要更多数据
+    bool parsePreamble_(const char *&p, const char *end, bool last);
+    bool parseDelimiterTail_(const char *&p, const char *end);
+    bool parsePartHeader_(const char *&p, const char *end);
+    bool parsePartData_(const char *&p, const char *end, bool last);
+    // 部分头解析完成，是文件时打开文件
+    void beginPart_();
+    // 写入文件内容
+    void writePart_(const char *data, size_t len);
+    // 部分结束，关闭文件
+    void endPart_();
+    // 解除文件的内存映射
+    void unmap_();
+    // 格式错误
+    void fail_(const char *reason);
+
+    static const size_t WRITE_SIZE = 256 * 1024;     // 攒够这么多文件内容再写
+    static const size_t PAGE_SIZE = 4096;            // 每次写的长度对齐到页大小
+    static const size_t MAX_PART_HEADER = 8192;      // 部分头的长度上限
+    static const size_t MAX_DELIMITER_TAIL = 256;    // 分隔行之后到CRLF的长度上限（允许空白填充）
+    static const size_t PIPE_SIZE = 1024 * 1024;     // splice使用的管道容量
+    static const size_t MAP_WINDOW = 8 * 1024 * 1024; // 查找分隔行时文件映射的窗口大小（映射的页缓存计入RSS）
+
+    STATE state_;          // 解析状态
+    std::string needle_;   // 要查找的"\r\n--分隔符"
+    std::string dir_;      // 保存文件的目录
+    bool discard_;         // 是否只解析不保存
+    bool atStart_;         // 是否在请求体开头，第一个分隔行前面可以没有CRLF
+    bool error_;           // 是否有部分格式错误或者保存失败
+    int files_;            // 保存成功的文件数
+    size_t headerLen_;     // 当前部分头已经解析的长度
+    size_t scanned_;       // 当前位置之后已经查找过、没有找到分隔行的长度，下次查找跳过这部分
+    std::string filename_; // 当前部分的文件名，不是文件时为空
+    std::string path_;     // 当前正在写的文件路径
+    int fd_;               // 当前正在写的文件描述符
+    off_t fileOff_;        // 当前文件已经写入的长度
+    // note: splice的数据不经过用户态，没有办法先查找分隔行，所以先写入文件，再把新写入的部分映射到内存中查找
+    // 找到分隔行时截断文件，之后的数据交回调用者的缓冲区按普通方式解析
+    bool spliced_;         // 当前部分是否处于splice状态
+    off_t verifyFrom_;     // splice状态下文件中从这里开始还没有检查过分隔行
+    char *map_;            // 文件映射窗口，只读
+    off_t mapOff_;         // 映射窗口在文件中的起始位置
+    int pipe_[2];          // splice使用的管道
+};
+
+#endif // MULTIPART_H
@@ -0,0 +1,180 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 21:02:37
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 21:02:37
+ */
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <string>
+#include <vector>
+#include <memory>    // unique_ptr
+#include <stdarg.h>  // va_list
+#include <stdio.h>   // vsnprintf
+#include <string.h>  // memcpy
+#include <assert.h>
+
+#include "log.h"
+#include "buffer.h"
+#include "stringview.h"
+
+class HttpRequest;
+class RequestView;
+class ResponseWriter;
+
+// 处理函数：读取请求，把响应写入ResponseWriter，在工作线程中调用，不能阻塞太久
+// note: 使用函数指针而不是std::function，不捕获变量的lambda可以直接转换，分发时没有堆内存分配
+typedef void (*RouteHandler)(const RequestView &request, ResponseWriter &response);
+
+/*
+ * 一次路由查找的结果：处理函数和路径参数
+ * 参数名指向路由树中的字符串，参数值指向请求路径，都是切片，不分配内存
+ */
+struct RouteMatch
+{
+    static const size_t MAX_PARAMS = 8; // 一个路由最多的路径参数个数
+
+    RouteHandler handler;           // 处理函数，没有匹配的路由时为nullptr
+    size_t paramCnt;                // 路径参数个数
+    StringView names[MAX_PARAMS];   // 路径参数名
+    StringView values[MAX_PARAMS];  // 路径参数值
+};
+
+/*
+ * 处理函数看到的请求
+ * 所有返回值都是切片，指向HttpRequest中保存的数据，处理函数返回前有效
+ */
+class RequestView
+{
+public:
+    explicit RequestView(const HttpRequest &request) : request_(request) {}
+    // 请求方法
+    StringView method() const;
+    // 请求路径，不包括查询字符串
+    StringView path() const;
+    // ?之后的查询字符串，没有时为空
+    StringView query() const;
+    // 请求头字段（不区分大小写），没有时为空
+    StringView header(const StringView &name) const;
+    // 路径参数（:name或*name），没有时为空
+    StringView param(const StringView &name) const;
+    // 请求体（Content-Length或分块传输编码解码后的数据）
+    StringView body() const;
+
+private:
+    const HttpRequest &request_;
+};
+
+/*
+ * 处理函数的响应，直接写入连接的写缓冲区，和静态文件的响应头一起由一次writev发送
+ * 先设置状态码和响应头，第一次写响应体时生成状态行和响应头，之后不能再修改
+ * Content-length在响应头中预留固定宽度，finish时填入实际长度，响应体不需要先写到别处再拷贝
+ */
+class ResponseWriter
+{
+public:
+    // isHead为true时（HEAD请求）只发送响应头，Content-length仍然是处理函数写入的响应体长度
+    ResponseWriter(Buffer &buff, bool isKeepAlive, bool isHead = false);
+    // 设置状态码，默认200
+    void setStatus(int code);
+    // 设置Content-type，默认text/plain
+    void setContentType(const StringView &type);
+    // 添加响应头字段，name和value在第一次写响应体之前必须有效
+    void addHeader(const StringView &name, const StringView &value);
+    // 写响应体
+    void write(const StringView &data);
+    // 按printf格式写响应体
+    void writef(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    // 直接在写缓冲区中追加响应体
+    Buffer &body();
+    // 完成响应：生成还没有生成的响应头，填入Content-length
+    void finish();
+    // 状态码
+    int status() const;
+
+private:
+    // 生成状态行和响应头
+    void writeHead_();
+    // 状态码的说明
+    static const char *reason_(int code);
+
+    static const size_t MAX_HEADERS = 16;    // 处理函数最多添加的响应头字段数
+    static const size_t LENGTH_WIDTH = 20;   // Content-length预留的宽度（size_t的最大位数）
+
+    Buffer &buff_;                           // 连接的写缓冲区
+    bool isKeepAlive_;                       // 是否保持长连接
+    bool isHead_;                            // 是否是HEAD请求，响应体不发送
+    int code_;                               // 状态码
+    StringView contentType_;                 // Content-type
+    StringView names_[MAX_HEADERS];          // 响应头字段名
+    StringView values_[MAX_HEADERS];         // 响应头字段值
+    size_t headerCnt_;                       // 响应头字段数
+    bool headWritten_;                       // 是否已经生成响应头
+    size_t lengthPos_;                       // 预留的Content-length值在写缓冲区可读数据中的位置
+    size_t bodyPos_;                         // 响应体在写缓冲区可读数据中的起始位置
+};
+
+/*
+ * 动态路由：方法+路径模式到处理函数的映射，用基数树（radix tree）保存
+ * 路径模式以/开头，:name匹配一段（到下一个/为止，不能为空），*name匹配剩下的全部（只能在最后）
+ * 比如 GET /api/users/:id、DELETE /api/users/:id，以及GET /api/files/加上*path（path匹配/api/files/之后的全部）
+ * 查找时静态片段优先，其次:name，最后*name，失败时回溯；查找不分配内存
+ * 路由在服务器启动前注册，之后只读，工作线程并发查找不需要加锁
+ * 没有匹配的请求（包括路径匹配但方法没有注册的）按原来的方式处理：静态文件、登录注册、上传
+ */
+class Router
+{
+public:
+    // 请求方法
+    enum METHOD
+    {
+        GET,
+        POST,
+        PUT,
+        DELETE,
+        PATCH,
+        HEAD,
+        OPTIONS,
+        METHOD_COUNT
+    };
+
+    // 单例模式
+    static Router *instance();
+    // 注册路由，模式格式错误或者与已有路由冲突时返回false
+    bool add(const char *method, const char *pattern, RouteHandler handler);
+    // 查找路由，找到时填充match并返回true，path可以带查询字符串
+    bool match(const StringView &method, const StringView &path, RouteMatch &match) const;
+    // 是否注册了路由
+    bool empty() const;
+
+private:
+    // 基数树节点
+    struct Node
+    {
+        std::string prefix;                         // 静态节点：路径片段；参数节点：参数名
+        std::vector<std::unique_ptr<Node>> children; // 静态子节点，首字符互不相同
+        std::unique_ptr<Node> param;                // :name子节点
+        std::unique_ptr<Node> wildcard;             // *name子节点
+        RouteHandler handlers[METHOD_COUNT];        // 以该节点结尾的路由的处理函数
+
+        Node() : handlers() {}
+    };
+
+    Router() : root_(new Node), count_(0) {}
+    ~Router() = default;
+    // 方法名对应的METHOD，不支持时返回-1
+    static int methodIndex_(const StringView &method);
+    // 在node下插入静态片段[p, end)，返回片段结尾所在的节点
+    static Node *insertStatic_(Node *node, const char *p, const char *end);
+    // 从node开始匹配[p, end)，node自身的片段已经匹配
+    static bool match_(const Node *node, const char *p, const char *end, int method, RouteMatch &match);
+
+    std::unique_ptr<Node> root_; // 根节点，片段为空
+    size_t count_;               // 注册的路由数
+};
+
+#endif // ROUTER_H
@@ -0,0 +1,90 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 20:14:08
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 20:14:08
+ */
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h> // memcmp
+
+#include "stringview.h"
+
+/*
+ * 静态路由表：请求路径到路由描述的映射，代替逐个比较DEFAULT_HTML和查找DEFAULT_HTML_TAG
+ * 路由在routetable.cpp的ROUTES中注册，编译期为这组路径找一个没有冲突的散列种子（完美散列），
+ * 查找时只计算一次散列、访问一个槽、比较一次字符串；不在表中的路径按普通静态文件处理
+ */
+class RouteTable
+{
+public:
+    // 路由的处理方式（POST表单请求体接收完成后）
+    enum HANDLER
+    {
+        NONE,    // 没有处理函数，只返回文件
+        LOGIN,   // 登录
+        REGISTER // 注册
+    };
+
+    // 路由描述
+    struct Route
+    {
+        const char *path;   // 请求路径
+        size_t len;         // 请求路径长度
+        const char *target; // 页面别名：实际返回的文件路径，nullptr表示返回path本身
+        HANDLER handler;    // 处理函数
+    };
+
+    // 查找请求路径对应的路由，没有注册时返回nullptr
+    static const Route *find(const StringView &path)
+    {
+        uint8_t index = SLOTS.index[hash(path.data(), path.size(), SEED) & (SLOT_COUNT - 1)];
+        if (index == EMPTY)
+        {
+            return nullptr;
+        }
+        const Route &route = ROUTES[index];
+        return route.len == path.size() && memcmp(route.path, path.data(), route.len) == 0 ? &route : nullptr;
+    }
+
+    // 路径的散列（FNV-1a），编译期和运行期使用同一个函数
+    static constexpr uint32_t hash(const char *data, size_t len, uint32_t seed)
+    {
+        uint32_t h = 2166136261u ^ seed;
+        for (size_t i = 0; i < len; i++)
+        {
+            h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        }
+        return h ^ (h >> 16);
+    }
+
+    static const size_t SLOT_COUNT = 64; // 槽数，2的幂，不小于路由数的两倍，种子更容易找到
+    static const uint8_t EMPTY = 0xff;   // 空槽
+
+private:
+    // 槽：路由在ROUTES中的下标，EMPTY表示空槽
+    struct Slots
+    {
+        uint8_t index[SLOT_COUNT];
+    };
+
+    // 编译期按种子把路由放入槽中，有冲突时返回false
+    static constexpr bool fill_(uint32_t seed, Slots &slots);
+    // 编译期从0开始查找没有冲突的散列种子
+    static constexpr uint32_t findSeed_();
+    // 编译期按找到的种子生成槽
+    static constexpr Slots buildSlots_();
+
+    static const Route ROUTES[];     // 注册的路由
+    static const size_t ROUTE_COUNT; // 路由数
+    static const uint32_t SEED;      // 编译期找到的散列种子
+    static const Slots SLOTS;        // 编译期生成的槽
+};
+
+#endif // ROUTE_TABLE_H
@@ -0,0 +1,58 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 17:26:44
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 17:26:44
+ */
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+/*
+ * HTTP报文的字符扫描，参考picohttpparser
+ * 启动时通过CPUID选择实现：AVX2（每次32字节）/SSE4.2（每次16字节）/标量，之后通过函数指针调用
+ * 所有函数都在[begin, end)中查找，没找到时返回end
+ */
+class SimdScan
+{
+public:
+    // 查找第一个CRLF，返回\r的位置
+    static const char *findCRLF(const char *begin, const char *end)
+    {
+        return findCRLF_(begin, end);
+    }
+    // 查找第一个非token字符（RFC 7230），用于扫描方法名和请求头字段名，请求头字段名之后的第一个非token字符应该是':'
+    static const char *findNonToken(const char *begin, const char *end)
+    {
+        return findNonToken_(begin, end);
+    }
+    // 查找第一个空格或控制字符（<=0x20或0x7f），用于扫描URL和版本
+    static const char *findSpaceOrCtl(const char *begin, const char *end)
+    {
+        return findSpaceOrCtl_(begin, end);
+    }
+    // 查找子串needle[0, len)第一次出现的位置，用于在multipart/form-data请求体中查找分隔行
+    static const char *find(const char *begin, const char *end, const char *needle, size_t len)
+    {
+        return find_(begin, end, needle, len);
+    }
+    // 是否是token字符
+    static bool isToken(char ch);
+    // 当前使用的实现：AVX2/SSE4.2/Scalar
+    static const char *isa();
+
+private:
+    typedef const char *(*ScanFunc)(const char *, const char *);
+    typedef const char *(*FindFunc)(const char *, const char *, const char *, size_t);
+
+    static ScanFunc findCRLF_;       // 查找CRLF的实现
+    static ScanFunc findNonToken_;   // 查找非token字符的实现
+    static ScanFunc findSpaceOrCtl_; // 查找空格或控制字符的实现
+    static FindFunc find_;           // 查找子串的实现
+};
+
+#endif // SIMD_SCAN_H
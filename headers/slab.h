@@ -0,0 +1,119 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 13:20:05
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 13:20:05
+ */
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <atomic>
+#include <memory>
+#include <assert.h>
+
+/*
+ * 按下标索引的对象池
+ * 对象按块（ChunkSize个）分配，块在第一次访问时分配并且不再释放，对象地址在整个生命周期内保持不变
+ * 查找只需要两次数组访问，没有哈希计算，预热（块分配完）之后不再有内存分配
+ * 块的分配使用CAS，多个线程可以同时访问
+ */
+template <class T, size_t ChunkSize = 1024>
+class Slab
+{
+public:
+    // 构造函数，maxSize为最大下标+1
+    explicit Slab(size_t maxSize);
+    // 析构函数，释放所有块
+    ~Slab();
+    // 返回下标对应的对象，所在块没有分配时先分配
+    T *get(size_t index);
+    // 返回下标对应的对象，所在块没有分配时返回nullptr
+    T *find(size_t index) const;
+    // 最大下标+1
+    size_t capacity() const;
+
+private:
+    size_t maxSize_;                             // 最大下标+1
+    size_t chunkNum_;                            // 块的个数
+    std::unique_ptr<std::atomic<T *>[]> chunks_; // 块指针数组，未分配的块为nullptr
+};
+
+/*
+ * 构造函数，只分配块指针数组
+ */
+template <class T, size_t ChunkSize>
+Slab<T, ChunkSize>::Slab(size_t maxSize) : maxSize_(maxSize), chunkNum_((maxSize + ChunkSize - 1) / ChunkSize),
+                                           chunks_(new std::atomic<T *>[(maxSize + ChunkSize - 1) / ChunkSize])
+{
+    assert(maxSize > 0);
+    for (size_t i = 0; i < chunkNum_; i++)
+    {
+        chunks_[i] = nullptr;
+    }
+}
+
+/*
+ * 析构函数，释放所有块
+ */
+template <class T, size_t ChunkSize>
+Slab<T, ChunkSize>::~Slab()
+{
+    for (size_t i = 0; i < chunkNum_; i++)
+    {
+        delete[] chunks_[i].load();
+    }
+}
+
+/*
+ * 返回下标对应的对象，所在块没有分配时先分配
+ * 多个线程同时分配同一个块时，只有CAS成功的那个块被使用，其余的释放
+ */
+template <class T, size_t ChunkSize>
+T *Slab<T, ChunkSize>::get(size_t index)
+{
+    assert(index < maxSize_);
+    std::atomic<T *> &slot = chunks_[index / ChunkSize];
+    T *chunk = slot.load(std::memory_order_acquire);
+    if (!chunk)
+    {
+        T *fresh = new T[ChunkSize];
+        if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+        {
+            chunk = fresh;
+        }
+        else
+        {
+            // 其他线程已经分配了，chunk被CAS更新为该块
+            delete[] fresh;
+        }
+    }
+    return chunk + index % ChunkSize;
+}
+
+/*
+ * 返回下标对应的对象，所在块没有分配时返回nullptr
+ */
+template <class T, size_t ChunkSize>
+T *Slab<T, ChunkSize>::find(size_t index) const
+{
+    if (index >= maxSize_)
+    {
+        return nullptr;
+    }
+    T *chunk = chunks_[index / ChunkSize].load(std::memory_order_acquire);
+    return chunk ? chunk + index % ChunkSize : nullptr;
+}
+
+/*
+ * 最大下标+1
+ */
+template <class T, size_t ChunkSize>
+size_t Slab<T, ChunkSize>::capacity() const
+{
+    return maxSize_;
+}
+
+#endif // SLAB_H
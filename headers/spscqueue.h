@@ -0,0 +1,107 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 10:12:31
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 10:12:31
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <assert.h>
+
+/*
+ * 无锁单生产者单消费者环形队列
+ * 容量为2的幂，读写下标各自只被一个线程修改，通过acquire/release保证可见性
+ * 用于主Reactor向子Reactor投递新连接
+ */
+template <class T>
+class SpscQueue
+{
+public:
+    // 构造函数，容量向上取整为2的幂
+    explicit SpscQueue(size_t capacity = 4096);
+    // 默认析构函数
+    ~SpscQueue() = default;
+    // 向队尾加入一个元素，队列满时返回false（仅生产者线程调用）
+    bool push(const T &item);
+    // 从队头弹出一个元素，队列空时返回false（仅消费者线程调用）
+    bool pop(T &item);
+    // 队列中元素个数（近似值）
+    size_t size() const;
+
+private:
+    std::vector<T> buffer_;   // 环形缓冲区
+    size_t mask_;             // 下标掩码，容量-1
+    // note: 读写下标之间填充一个缓存行，避免生产者和消费者之间的伪共享
+    std::atomic<size_t> head_; // 读下标，只被消费者修改
+    char pad_[64];             // 缓存行填充
+    std::atomic<size_t> tail_; // 写下标，只被生产者修改
+};
+
+/*
+ * 构造函数，容量向上取整为2的幂
+ */
+template <class T>
+SpscQueue<T>::SpscQueue(size_t capacity) : head_(0), tail_(0)
+{
+    assert(capacity > 0);
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+}
+
+/*
+ * 向队尾加入一个元素，队列满时返回false
+ */
+template <class T>
+bool SpscQueue<T>::push(const T &item)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    // 队列已满
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+    {
+        return false;
+    }
+    buffer_[tail & mask_] = item;
+    // release保证消费者看到新的tail_时元素已经写入
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+ * 从队头弹出一个元素，队列空时返回false
+ */
+template <class T>
+bool SpscQueue<T>::pop(T &item)
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+    // 队列为空
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    item = buffer_[head & mask_];
+    // release保证生产者看到新的head_时元素已经被取走
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+ * 队列中元素个数（近似值）
+ */
+template <class T>
+size_t SpscQueue<T>::size() const
+{
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,99 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 16:52:36
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 16:52:36
+ */
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+
+#include <string>
+#include <string.h>
+#include <strings.h> // strncasecmp()
+
+/*
+ * 只读字符串切片（C++14没有std::string_view）
+ * 只保存指针和长度，不拥有内存，不会分配堆内存，切片的有效期由底层内存决定
+ */
+class StringView
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1); // 未找到
+
+    // 空切片
+    StringView() : data_(nullptr), size_(0) {}
+    // 指定起始位置和长度
+    StringView(const char *data, size_t size) : data_(data), size_(size) {}
+    // 以'\0'结尾的字符串
+    StringView(const char *str) : data_(str), size_(strlen(str)) {}
+    // std::string，切片在str修改或析构之前有效
+    StringView(const std::string &str) : data_(str.data()), size_(str.size()) {}
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char *begin() const { return data_; }
+    const char *end() const { return data_ + size_; }
+    char operator[](size_t i) const { return data_[i]; }
+
+    // 内容是否相同
+    bool operator==(const StringView &other) const
+    {
+        return size_ == other.size_ && (size_ == 0 || memcmp(data_, other.data_, size_) == 0);
+    }
+    bool operator!=(const StringView &other) const { return !(*this == other); }
+
+    // 忽略大小写比较内容是否相同（HTTP的头部字段名、部分字段值不区分大小写）
+    bool equalsIgnoreCase(const StringView &other) const
+    {
+        return size_ == other.size_ && (size_ == 0 || strncasecmp(data_, other.data_, size_) == 0);
+    }
+
+    // 是否以prefix开头
+    bool startsWith(const StringView &prefix) const
+    {
+        return size_ >= prefix.size_ && StringView(data_, prefix.size_) == prefix;
+    }
+
+    // 从pos开始查找子串，未找到返回npos
+    size_t find(const StringView &str, size_t pos = 0) const
+    {
+        if (str.size_ == 0)
+        {
+            return pos <= size_ ? pos : npos;
+        }
+        for (size_t i = pos; i + str.size_ <= size_; i++)
+        {
+            if (data_[i] == str.data_[0] && memcmp(data_ + i, str.data_, str.size_) == 0)
+            {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    // 从pos开始长度为n的子切片
+    StringView substr(size_t pos, size_t n = npos) const
+    {
+        if (pos > size_)
+        {
+            pos = size_;
+        }
+        return StringView(data_ + pos, n < size_ - pos ? n : size_ - pos);
+    }
+
+    // 转为std::string（会拷贝）
+    std::string toString() const
+    {
+        return std::string(data_, size_);
+    }
+
+private:
+    const char *data_; // 起始位置
+    size_t size_;      // 长度
+};
+
+#endif // STRING_VIEW_H
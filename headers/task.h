@@ -0,0 +1,69 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 15:48:52
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 15:48:52
+ */
+#ifndef TASK_H
+#define TASK_H
+
+#include <new>
+#include <utility>
+#include <stddef.h>
+#include <type_traits>
+
+/*
+ * 定长任务对象，代替std::bind+std::function
+ * 可调用对象直接存放在对象内部的定长缓冲区中，通过函数指针调用，不需要堆内存分配和虚函数
+ * 只接受可平凡复制、大小不超过STORAGE的可调用对象（比如捕获[this, reactor, client]的lambda），
+ * 所以Task本身也是可平凡复制的，可以直接memcpy，也可以放进无锁队列
+ */
+class Task
+{
+public:
+    static const size_t STORAGE = 32; // 内部缓冲区大小，可以存放4个指针
+
+    // 默认构造函数，空任务
+    Task() : invoke_(nullptr) {}
+
+    // 从可调用对象构造，可调用对象按值拷贝到内部缓冲区
+    // note: enable_if排除Task自身，否则模板会优先于拷贝构造函数匹配非const的Task对象
+    template <class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F &&f)
+    {
+        typedef typename std::decay<F>::type Func;
+        static_assert(sizeof(Func) <= STORAGE, "Task callable is too large");
+        static_assert(alignof(Func) <= alignof(void *), "Task callable is over-aligned");
+        static_assert(std::is_trivially_copyable<Func>::value, "Task callable must be trivially copyable");
+        new (storage_) Func(std::forward<F>(f));
+        invoke_ = &call_<Func>;
+    }
+
+    // 执行任务
+    void operator()()
+    {
+        invoke_(storage_);
+    }
+
+    // 是否为非空任务
+    explicit operator bool() const
+    {
+        return invoke_ != nullptr;
+    }
+
+private:
+    // 以存放的可调用对象的实际类型调用
+    template <class Func>
+    static void call_(void *storage)
+    {
+        (*static_cast<Func *>(storage))();
+    }
+
+    void (*invoke_)(void *);                         // 调用函数指针，为nullptr表示空任务
+    alignas(void *) unsigned char storage_[STORAGE]; // 存放可调用对象的缓冲区
+};
+
+#endif // TASK_H
@@ -1,65 +1,115 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
-#include <queue>
+#include <memory>
+#include <random>
 #include <thread>
-#include <functional>
+#include <vector>
+#include <algorithm>
 #include <condition_variable>
 #include <assert.h>
+#include <pthread.h> // pthread_setaffinity_np()
+
+#include "task.h"
+#include "wsdeque.h"
+#include "mpmcqueue.h"
 
 class ThreadPool
 {
 public:
+    // 任务调度模式
+    enum MODE
+    {
+        SHARED = 0, // 所有工作线程共享一个加锁的任务队列
+        STEALING,   // 工作窃取：全局注入队列+每个工作线程一个Chase-Lev双端队列
+        AFFINITY,   // 亲和：每个工作线程一个加锁的任务队列，按键（比如fd）哈希到固定的工作线程
+        LOCKFREE,   // 所有工作线程共享一个无锁MPMC环形队列，空闲线程通过futex休眠
+    };
+
+    static const size_t ANY = static_cast<size_t>(-1); // 不指定键，亲和模式下轮询分配
+
+    // 任务队列已满时的拒绝策略
+    enum POLICY
+    {
+        REJECT = 0,  // 拒绝新任务
+        CALLER_RUNS, // 由添加任务的线程直接执行新任务
+        DROP_OLDEST, // 丢弃队列中最早的任务，再加入新任务
+    };
+
     /*
      * 构造函数中根据传入的参数构建线程池
      * 线程是调用detach
+     * maxTasks为任务队列的最大长度，0表示不限制；工作窃取模式下只限制全局注入队列，每个双端队列本身是定长的
+     * codelTarget/codelInterval为CoDel准入控制的目标排队时间和观察区间（毫秒），codelTarget为0表示关闭
+     * 亲和模式下每个工作线程有独立的任务队列，队列长度限制和CoDel分别作用于每个队列
+     * 无锁队列模式下队列容量为maxTasks（向上取整为2的幂），maxTasks为0时为RING_CAPACITY，队列满时同样按拒绝策略处理
+     * pinCpu为true时第i个工作线程绑定到第i%核数个CPU上
+     * 共享队列模式下maxThreads大于threadCount时线程数在[threadCount, maxThreads]之间动态调整（见push_和sharedWorker_），
+     * 其余模式下线程数固定为threadCount
      */
     // note: explicit关键字防止构造函数隐式转换
-    explicit ThreadPool(size_t threadCount = 8) : pool_(std::make_shared<Pool>())
+    explicit ThreadPool(size_t threadCount = 8, MODE mode = SHARED, size_t maxTasks = 0, POLICY policy = REJECT,
+                        int codelTarget = 0, int codelInterval = 100, bool pinCpu = false, size_t maxThreads = 0)
     {
         assert(threadCount > 0);
+        // 亲和模式下每个工作线程一个Pool，其余模式所有工作线程共享一个Pool
+        size_t poolCount = mode == AFFINITY ? threadCount : 1;
+        for (size_t i = 0; i < poolCount; i++)
+        {
+            std::shared_ptr<Pool> pool = std::make_shared<Pool>();
+            pool->isClosed = false;
+            pool->mode = mode;
+            pool->idleCount = 0;
+            pool->maxTasks = maxTasks;
+            pool->policy = policy;
+            pool->peakTasks = 0;
+            pool->rejectCount = 0;
+            pool->dropCount = 0;
+            pool->callerRunsCount = 0;
+            pool->codelTarget = std::chrono::milliseconds(std::max(codelTarget, 0));
+            pool->codelInterval = std::chrono::milliseconds(std::max(codelInterval, 1));
+            pool->intervalEnd = SteadyClock::now() + pool->codelInterval;
+            pool->minDelay = SteadyClock::duration::max();
+            pool->overloaded = false;
+            pool->shedCount = 0;
+            pool->nextPool = 0;
+            pool->pinCpu = pinCpu;
+            pool->threadCount = mode == AFFINITY ? 1 : threadCount;
+            pool->minThreads = pool->threadCount;
+            pool->maxThreads = mode == SHARED ? std::max(maxThreads, threadCount) : pool->threadCount;
+            pool->growCount = 0;
+            pool->shrinkCount = 0;
+            pools_.push_back(pool);
+        }
+        std::shared_ptr<Pool> &pool = pools_[0];
+        if (mode == STEALING)
+        {
+            for (size_t i = 0; i < threadCount; i++)
+            {
+                pool->deques.emplace_back(new WsDeque<Job>(DEQUE_CAPACITY));
+            }
+        }
+        else if (mode == LOCKFREE)
+        {
+            pool->ring.reset(new MpmcQueue<Job>(maxTasks > 0 ? maxTasks : RING_CAPACITY));
+        }
 
         for (size_t i = 0; i < threadCount; i++)
         {
-            // 使用lambda表达式构建执行对象
-            std::thread([pool = pool_]
-                        {
-                // 初始化一个unique lock后面通过此对象的lock与unlock方法进行加锁与解锁，这样比每次都初始化一个unique lock对象要省资源
-                // note: unique_lock、lock_guard和mutex
-                // unique_lock和lock_guard在构造函数时上锁，作用域外自动解锁
-                std::unique_lock<std::mutex> locker(pool->mtx);
-                // 此时加锁，下面的代码是临界区，访问pool
-                ///////////////////////////////////
-                while (true)
+            if (mode == STEALING || mode == LOCKFREE)
+            {
+                std::thread worker = mode == STEALING ? std::thread(stealingWorker_, pool, i) : std::thread(lockfreeWorker_, pool);
+                if (pinCpu)
                 {
-                    // 任务队列不为空，进入本段代码，采用右值的方式取出任务
-                    // 任务取出成功，解锁，执行完任务重新获取锁
-                    if (!pool->tasks.empty())
-                    {
-                        auto task = std::move(pool->tasks.front());
-                        pool->tasks.pop();
-                        ///////////////////////////
-                        // 此时解锁，上面的代码是临界区
-                        locker.unlock();
-                        // 执行任务，不在临界区
-                        task();
-                        // 此时加锁，因为下一次while循环需要访问临界区
-                        locker.lock();
-                    }
-                    // 说明线程池收到了关闭信号，直接跳出循环
-                    else if (pool->isClosed)
-                    {
-                        break;
-                    }
-                    // 到了此分支，说明任务队列为空，此时条件变量等待
-                    // note: wait方法会自动释放锁，当收到notify信号时重新尝试获取锁
-                    else
-                    {
-                        pool->cond.wait(locker);
-                    }
-                } })
-                .detach(); // detach的形式运行线程
+                    pinThread_(worker, i);
+                }
+                worker.detach(); // detach的形式运行线程
+                continue;
+            }
+            spawn_(pools_[mode == AFFINITY ? i : 0], i);
         }
     }
 
@@ -70,50 +120,684 @@ public:
     ThreadPool(ThreadPool &&) = default;
 
     /*
-     * 析构函数中将pool_->isClosed = true;标志置为false，这样detach的线程会自动关闭
+     * 析构函数中将pool->isClosed = true;标志置为false，这样detach的线程会自动关闭
      */
     ~ThreadPool()
     {
-        if (static_cast<bool>(pool_))
+        for (auto &pool : pools_)
         {
             // 同addTask函数，RAII思想
             {
-                std::lock_guard<std::mutex> locker(pool_->mtx);
-                pool_->isClosed = true;
+                std::lock_guard<std::mutex> locker(pool->mtx);
+                pool->isClosed = true;
             }
             // 唤醒所有线程，这个线程池的逻辑是执行完了任务队列中的所有任务后才会退出线程
-            pool_->cond.notify_all();
+            pool->cond.notify_all();
+            if (pool->ring)
+            {
+                pool->ring->close();
+            }
         }
     }
 
     /*
      * 类成员模板函数，参数自动推断，向任务队列中添加任务
-     * 这里可以设置一个最大任务数量，若超过此数量，禁止向队列加入任务
+     * 工作窃取模式下任务先进入全局注入队列，由工作线程批量取到自己的双端队列中
+     * 可调用对象被拷贝到定长的Task中（见task.h），队列是预分配的环形缓冲区，稳定状态下添加任务没有堆内存分配
      */
     template <class F>
-    void addTask(F &&task)
+    bool addTask(F &&task)
     {
-        // note: 利用RAII自动加锁解锁下面这块作用域，此处使用lock_guard，{}是作用域
+        return addTask(std::forward<F>(task), Task(), ANY);
+    }
+
+    /*
+     * 向任务队列中添加任务，同时指定任务被拒绝或被丢弃时的回调reject
+     * 队列达到maxTasks时按拒绝策略处理：
+     * REJECT：在当前线程调用新任务的reject，返回false
+     * CALLER_RUNS：在当前线程直接执行新任务
+     * DROP_OLDEST：丢弃队列中最早的任务，在当前线程调用它的reject，新任务入队
+     * 开启CoDel时，排队时间持续超过目标值（过载）期间新任务直接被拒绝，与队列长度无关
+     * reject回调都在锁外调用
+     * 亲和模式下键相同的任务总是由同一个工作线程执行，其余模式忽略key
+     */
+    template <class F, class R>
+    bool addTask(F &&task, R &&reject, size_t key = ANY)
+    {
+        // 在锁外构造Task
+        Job item = {Task(std::forward<F>(task)), Task(std::forward<R>(reject)), SteadyClock::time_point()};
+        if (pools_.size() > 1 && key == ANY)
+        {
+            key = pools_[0]->nextPool++;
+        }
+        if (pools_[0]->ring)
+        {
+            return ringPush_(pools_[0], item);
+        }
+        return push_(pools_.size() > 1 ? pools_[key % pools_.size()] : pools_[0], item);
+    }
+
+    /*
+     * 当前排队的任务数（工作窃取模式下包括各双端队列中的任务，工作窃取和无锁队列模式下为近似值）
+     */
+    size_t queueSize() const
+    {
+        size_t size = 0;
+        for (auto &pool : pools_)
+        {
+            {
+                std::lock_guard<std::mutex> locker(pool->mtx);
+                size += pool->tasks.size();
+            }
+            for (auto &deque : pool->deques)
+            {
+                size += deque->size();
+            }
+            if (pool->ring)
+            {
+                size += pool->ring->size();
+            }
+        }
+        return size;
+    }
+
+    // 任务队列（工作窃取模式下为全局注入队列）的历史最大长度，亲和模式下为各队列中的最大值
+    size_t peakQueueSize() const
+    {
+        size_t peak = 0;
+        for (auto &pool : pools_)
+        {
+            std::lock_guard<std::mutex> locker(pool->mtx);
+            peak = std::max(peak, pool->peakTasks.load());
+        }
+        return peak;
+    }
+
+    // 队列已满时被拒绝的任务数
+    uint64_t rejectCount() const { return sum_(&Pool::rejectCount); }
+
+    // 队列已满时被丢弃的最早任务数
+    uint64_t dropCount() const { return sum_(&Pool::dropCount); }
+
+    // 队列已满时由添加任务的线程直接执行的任务数
+    uint64_t callerRunsCount() const { return sum_(&Pool::callerRunsCount); }
+
+    // CoDel判定过载而拒绝的任务数
+    uint64_t shedCount() const { return sum_(&Pool::shedCount); }
+
+    // 当前的工作线程数
+    size_t threadCount() const
+    {
+        size_t count = 0;
+        for (auto &pool : pools_)
         {
-            std::lock_guard<std::mutex> locker(pool_->mtx);
-            // 完美转发
-            pool_->tasks.emplace(std::forward<F>(task));
+            std::lock_guard<std::mutex> locker(pool->mtx);
+            count += pool->threadCount;
         }
-        // 加入一个任务，唤醒一个线程
-        pool_->cond.notify_one();
+        return count;
+    }
+
+    // 因排队而新增的工作线程数
+    uint64_t growCount() const { return sum_(&Pool::growCount); }
+
+    // 因空闲而退出的工作线程数
+    uint64_t shrinkCount() const { return sum_(&Pool::shrinkCount); }
+
+    /*
+     * 运行时调整线程数的范围（只支持共享队列模式，其余模式返回false）
+     * 线程数小于minThreads时立即创建新线程，大于maxThreads时多余的线程执行完手上的任务后退出
+     * minThreads等于maxThreads时线程数固定
+     */
+    bool resize(size_t minThreads, size_t maxThreads)
+    {
+        std::shared_ptr<Pool> &pool = pools_[0];
+        if (pool->mode != SHARED || minThreads == 0 || minThreads > maxThreads)
+        {
+            return false;
+        }
+        size_t spawnFrom = 0, spawnTo = 0;
+        {
+            std::lock_guard<std::mutex> locker(pool->mtx);
+            pool->minThreads = minThreads;
+            pool->maxThreads = maxThreads;
+            if (pool->threadCount < minThreads)
+            {
+                spawnFrom = pool->threadCount;
+                spawnTo = minThreads;
+                pool->threadCount = minThreads;
+            }
+        }
+        for (size_t i = spawnFrom; i < spawnTo; i++)
+        {
+            spawn_(pool, i);
+        }
+        // 唤醒空闲线程检查是否需要退出
+        pool->cond.notify_all();
+        return true;
     }
 
 private:
+    static const size_t DEQUE_CAPACITY = 256; // 每个工作线程双端队列的容量
+    static const size_t BATCH_SIZE = 16;      // 工作线程每次从全局队列批量取出的最大任务数
+    static const size_t RING_CAPACITY = 65536; // 无锁队列模式下不限制队列长度时的环形队列容量
+    static const int DROP_RETRY = 4;          // 无锁队列模式下DROP_OLDEST丢弃最早任务后重新入队的最大次数
+    // note: 头文件中的类没有地方定义静态常量，不能按引用传递（比如直接传给duration的构造函数），否则不优化编译时链接失败
+    static const int GROW_DELAY_MS = 5;       // 动态调整线程数时，队头任务排队超过该时间且没有空闲线程则新增线程
+    static const int IDLE_TIMEOUT_MS = 30000; // 动态调整线程数时，线程空闲超过该时间则退出
+
+    typedef std::chrono::steady_clock SteadyClock; // 计算排队时间的单调时钟
+
+    // 队列中的任务：要执行的任务以及任务被拒绝或被丢弃时的回调（可以为空）
+    struct Job
+    {
+        Task run;                         // 任务
+        Task reject;                      // 拒绝回调
+        SteadyClock::time_point enqueued; // 入队时间，开启CoDel时记录
+    };
+
+    /*
+     * 任务环形队列，容量不够时翻倍，之后不再分配内存（std::queue底层的std::deque会随着push/pop反复分配和释放内存块）
+     * 不是线程安全的，由Pool::mtx保护
+     */
+    class TaskQueue
+    {
+    public:
+        explicit TaskQueue(size_t capacity = 1024) : buffer_(capacity), head_(0), size_(0) {}
+        bool empty() const { return size_ == 0; }
+        size_t size() const { return size_; }
+        Job &front() { return buffer_[head_]; }
+        void pop()
+        {
+            head_ = (head_ + 1) % buffer_.size();
+            size_--;
+        }
+        void push(const Job &job)
+        {
+            if (size_ == buffer_.size())
+            {
+                // 按队列顺序搬到新的缓冲区
+                std::vector<Job> buffer(buffer_.size() * 2);
+                for (size_t i = 0; i < size_; i++)
+                {
+                    buffer[i] = buffer_[(head_ + i) % buffer_.size()];
+                }
+                buffer_.swap(buffer);
+                head_ = 0;
+            }
+            buffer_[(head_ + size_) % buffer_.size()] = job;
+            size_++;
+        }
+
+    private:
+        std::vector<Job> buffer_;  // 环形缓冲区
+        size_t head_;              // 队头下标
+        size_t size_;              // 任务个数
+    };
+
     /*定义一个结构体，保存相关变量*/
     struct Pool
     {
-        std::mutex mtx;                          // 互斥量
-        std::condition_variable cond;            // 条件变量
-        bool isClosed;                           // 标志变量，表示是否关闭线程池
-        std::queue<std::function<void()>> tasks; // 任务队列
+        std::mutex mtx;                        // 互斥量
+        std::condition_variable cond;          // 条件变量
+        bool isClosed;                         // 标志变量，表示是否关闭线程池
+        TaskQueue tasks;                       // 任务队列，工作窃取模式下为全局注入队列
+        MODE mode;                             // 任务调度模式
+        size_t idleCount;                      // 阻塞在条件变量上的线程数，受mtx保护
+        size_t maxTasks;                       // 任务队列的最大长度，0表示不限制
+        POLICY policy;                         // 队列已满时的拒绝策略
+        std::atomic<size_t> peakTasks;         // 任务队列的历史最大长度，受mtx保护（无锁队列模式下用CAS更新）
+        std::atomic<uint64_t> rejectCount;     // 被拒绝的任务数
+        std::atomic<uint64_t> dropCount;       // 被丢弃的任务数
+        std::atomic<uint64_t> callerRunsCount; // 由添加任务的线程执行的任务数
+        // note: CoDel状态，受mtx保护，在工作线程从任务队列取任务时更新，队列空闲之后在添加任务时过期
+        SteadyClock::duration codelTarget;     // 目标排队时间，0表示关闭
+        SteadyClock::duration codelInterval;   // 观察区间
+        SteadyClock::time_point intervalEnd;   // 当前观察区间的结束时间
+        SteadyClock::duration minDelay;        // 当前观察区间内的最小排队时间
+        std::atomic<bool> overloaded;          // 上一个观察区间的最小排队时间是否超过目标值（无锁队列模式下在锁外读）
+        std::atomic<uint64_t> shedCount;       // CoDel拒绝的任务数
+        std::atomic<size_t> nextPool;          // 亲和模式下不指定键的任务轮询分配的计数（只使用第0个Pool的）
+        bool pinCpu;                           // 工作线程是否绑定CPU
+        size_t threadCount;                    // 当前的工作线程数，受mtx保护
+        size_t minThreads;                     // 工作线程数下限，受mtx保护
+        size_t maxThreads;                     // 工作线程数上限，受mtx保护
+        std::atomic<uint64_t> growCount;       // 新增的工作线程数
+        std::atomic<uint64_t> shrinkCount;     // 退出的工作线程数
+        // note: Job可平凡复制，直接存放在Chase-Lev双端队列中
+        std::vector<std::unique_ptr<WsDeque<Job>>> deques; // 每个工作线程的双端队列
+        std::unique_ptr<MpmcQueue<Job>> ring;              // 无锁队列模式下的任务队列，代替tasks
     };
 
-    std::shared_ptr<Pool> pool_; // 因为线程是在detach模式下运行的，所以这里使用动态申请的堆内存空间，使用shareptr管理
+    /*
+     * 把任务加入pool的任务队列，按CoDel状态和拒绝策略处理，见addTask
+     */
+    static bool push_(const std::shared_ptr<Pool> &pool, Job &item)
+    {
+        Job dropped;
+        bool shed = false;
+        bool full = false;
+        bool notify = false;
+        bool grow = false;
+        size_t index = 0;
+        bool codel = pool->codelTarget.count() > 0;
+        // note: 利用RAII自动加锁解锁下面这块作用域，此处使用lock_guard，{}是作用域
+        {
+            std::lock_guard<std::mutex> locker(pool->mtx);
+            // 开启CoDel或者动态调整线程数时记录入队时间
+            bool dynamic = pool->maxThreads > pool->minThreads;
+            if (codel || dynamic)
+            {
+                item.enqueued = SteadyClock::now();
+            }
+            // 没有空闲线程并且队头任务已经排队超过GROW_DELAY_MS，说明现有线程处理不过来，新增一个线程
+            if (dynamic && pool->idleCount == 0 && pool->threadCount < pool->maxThreads && !pool->tasks.empty() &&
+                item.enqueued - pool->tasks.front().enqueued >= std::chrono::milliseconds(static_cast<int>(GROW_DELAY_MS)))
+            {
+                grow = true;
+                index = pool->threadCount++;
+                pool->growCount++;
+            }
+            // 过载状态只在任务出队时更新，空闲一段时间后需要在这里让它过期：
+            // 队列已经取空说明积压已经消失，清除过载状态；整个观察区间内没有任务出队时，用队头任务的排队时间重新判断
+            if (codel && pool->overloaded)
+            {
+                if (pool->tasks.empty())
+                {
+                    codelReset_(pool.get(), item.enqueued);
+                }
+                else if (item.enqueued >= pool->intervalEnd)
+                {
+                    codel_(pool.get(), pool->tasks.front().enqueued);
+                }
+            }
+            // 队列为空时新任务不需要排队，即使处于过载状态也接收
+            shed = codel && pool->overloaded && !pool->tasks.empty();
+            full = !shed && pool->maxTasks > 0 && pool->tasks.size() >= pool->maxTasks;
+            if (full && pool->policy == DROP_OLDEST)
+            {
+                dropped = pool->tasks.front();
+                pool->tasks.pop();
+                pool->dropCount++;
+            }
+            if (!shed && (!full || pool->policy == DROP_OLDEST))
+            {
+                pool->tasks.push(item);
+                pool->peakTasks = std::max(pool->peakTasks.load(), pool->tasks.size());
+                notify = true;
+            }
+        }
+        // 在锁外创建线程
+        if (grow)
+        {
+            spawn_(pool, index);
+        }
+        // 过载，拒绝新任务
+        if (shed)
+        {
+            pool->shedCount++;
+            if (item.reject)
+            {
+                item.reject();
+            }
+            return false;
+        }
+        if (!full)
+        {
+            // 加入一个任务，唤醒一个线程
+            if (notify)
+            {
+                pool->cond.notify_one();
+            }
+            return true;
+        }
+        switch (pool->policy)
+        {
+        case CALLER_RUNS:
+            pool->callerRunsCount++;
+            item.run();
+            return true;
+        case DROP_OLDEST:
+            if (notify)
+            {
+                pool->cond.notify_one();
+            }
+            if (dropped.reject)
+            {
+                dropped.reject();
+            }
+            return true;
+        default:
+            pool->rejectCount++;
+            if (item.reject)
+            {
+                item.reject();
+            }
+            return false;
+        }
+    }
+
+    /*
+     * 无锁队列模式下把任务加入环形队列，不加锁，拒绝策略和CoDel的语义同push_
+     */
+    static bool ringPush_(const std::shared_ptr<Pool> &pool, Job &item)
+    {
+        MpmcQueue<Job> &ring = *pool->ring;
+        if (pool->codelTarget.count() > 0)
+        {
+            item.enqueued = SteadyClock::now();
+            // 队列已经取空时清除过载状态（同push_），拿不到锁时由之后的任务或工作线程更新
+            if (pool->overloaded.load(std::memory_order_relaxed) && ring.size() == 0)
+            {
+                std::unique_lock<std::mutex> locker(pool->mtx, std::try_to_lock);
+                if (locker.owns_lock())
+                {
+                    codelReset_(pool.get(), item.enqueued);
+                }
+            }
+            // 队列为空时新任务不需要排队，即使处于过载状态也接收
+            if (pool->overloaded.load(std::memory_order_relaxed) && ring.size() > 0)
+            {
+                pool->shedCount++;
+                if (item.reject)
+                {
+                    item.reject();
+                }
+                return false;
+            }
+        }
+        bool pushed = ring.tryPush(item);
+        // 丢弃最早的任务后重新入队，腾出的槽可能被其他生产者抢走，所以最多重试DROP_RETRY次
+        for (int i = 0; !pushed && pool->policy == DROP_OLDEST && i < DROP_RETRY; i++)
+        {
+            Job dropped;
+            if (ring.tryPop(dropped))
+            {
+                pool->dropCount++;
+                if (dropped.reject)
+                {
+                    dropped.reject();
+                }
+            }
+            pushed = ring.tryPush(item);
+        }
+        if (pushed)
+        {
+            size_t size = ring.size();
+            size_t peak = pool->peakTasks.load(std::memory_order_relaxed);
+            while (size > peak && !pool->peakTasks.compare_exchange_weak(peak, size, std::memory_order_relaxed))
+            {
+            }
+            return true;
+        }
+        if (pool->policy == CALLER_RUNS)
+        {
+            pool->callerRunsCount++;
+            item.run();
+            return true;
+        }
+        pool->rejectCount++;
+        if (item.reject)
+        {
+            item.reject();
+        }
+        return false;
+    }
+
+    /*
+     * 各Pool的计数之和
+     */
+    uint64_t sum_(std::atomic<uint64_t> Pool::*counter) const
+    {
+        uint64_t sum = 0;
+        for (auto &pool : pools_)
+        {
+            sum += (*pool.*counter).load();
+        }
+        return sum;
+    }
+
+    /*
+     * 把线程绑定到第index%核数个CPU上，绑定失败时忽略
+     */
+    static void pinThread_(std::thread &thread, size_t index)
+    {
+        size_t cpuNum = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(index % cpuNum, &cpuset);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpuset), &cpuset);
+    }
+
+    /*
+     * 创建一个运行sharedWorker_的线程，调用者已经把它计入了threadCount
+     */
+    static void spawn_(const std::shared_ptr<Pool> &pool, size_t index)
+    {
+        std::thread worker(sharedWorker_, pool);
+        if (pool->pinCpu)
+        {
+            pinThread_(worker, index);
+        }
+        worker.detach(); // detach的形式运行线程
+    }
+
+    /*
+     * 共享队列模式（以及亲和模式下每个线程独占的队列）的工作线程
+     * 动态调整线程数时，线程数超过上限（resize调小）或空闲超过IDLE_TIMEOUT_MS且线程数超过下限时退出
+     */
+    static void sharedWorker_(std::shared_ptr<Pool> pool)
+    {
+        // 初始化一个unique lock后面通过此对象的lock与unlock方法进行加锁与解锁，这样比每次都初始化一个unique lock对象要省资源
+        // note: unique_lock、lock_guard和mutex
+        // unique_lock和lock_guard在构造函数时上锁，作用域外自动解锁
+        std::unique_lock<std::mutex> locker(pool->mtx);
+        // 此时加锁，下面的代码是临界区，访问pool
+        ///////////////////////////////////
+        while (true)
+        {
+            // resize调小了上限，多余的线程退出
+            if (pool->threadCount > pool->maxThreads)
+            {
+                pool->threadCount--;
+                pool->shrinkCount++;
+                break;
+            }
+            // 任务队列不为空，进入本段代码，采用右值的方式取出任务
+            // 任务取出成功，解锁，执行完任务重新获取锁
+            if (!pool->tasks.empty())
+            {
+                Job job = popTask_(pool.get());
+                ///////////////////////////
+                // 此时解锁，上面的代码是临界区
+                locker.unlock();
+                // 执行任务，不在临界区
+                job.run();
+                // 此时加锁，因为下一次while循环需要访问临界区
+                locker.lock();
+            }
+            // 说明线程池收到了关闭信号，直接跳出循环
+            else if (pool->isClosed)
+            {
+                break;
+            }
+            // 到了此分支，说明任务队列为空，此时条件变量等待
+            // note: wait方法会自动释放锁，当收到notify信号时重新尝试获取锁
+            else if (pool->maxThreads == pool->minThreads)
+            {
+                pool->idleCount++;
+                pool->cond.wait(locker);
+                pool->idleCount--;
+            }
+            // 动态调整线程数时最多等待IDLE_TIMEOUT_MS，超时仍然没有任务并且线程数超过下限则退出
+            else
+            {
+                pool->idleCount++;
+                std::cv_status status = pool->cond.wait_for(locker, std::chrono::milliseconds(static_cast<int>(IDLE_TIMEOUT_MS)));
+                pool->idleCount--;
+                if (status == std::cv_status::timeout && pool->tasks.empty() && pool->threadCount > pool->minThreads)
+                {
+                    pool->threadCount--;
+                    pool->shrinkCount++;
+                    break;
+                }
+            }
+        }
+    }
+
+    /*
+     * 从任务队列取出一个任务，加锁后调用
+     * 开启CoDel时记录该任务的排队时间：每个观察区间结束时，区间内最小排队时间超过目标值说明队列持续积压（而不是短暂的突发），
+     * 进入过载状态，addTask拒绝新任务，直到某个区间内的最小排队时间回落到目标值以下
+     * 工作窃取模式下只统计在全局注入队列中的排队时间
+     */
+    static Job popTask_(Pool *pool)
+    {
+        Job job = pool->tasks.front();
+        pool->tasks.pop();
+        if (pool->codelTarget.count() > 0)
+        {
+            codel_(pool, job.enqueued);
+        }
+        return job;
+    }
+
+    /*
+     * 记录一个任务的排队时间，更新CoDel状态，加锁后调用
+     */
+    static void codel_(Pool *pool, SteadyClock::time_point enqueued)
+    {
+        SteadyClock::time_point now = SteadyClock::now();
+        pool->minDelay = std::min(pool->minDelay, now - enqueued);
+        if (now >= pool->intervalEnd)
+        {
+            pool->overloaded = pool->minDelay > pool->codelTarget;
+            pool->minDelay = SteadyClock::duration::max();
+            pool->intervalEnd = now + pool->codelInterval;
+        }
+    }
+
+    /*
+     * 清除过载状态，从now开始新的观察区间，加锁后调用
+     */
+    static void codelReset_(Pool *pool, SteadyClock::time_point now)
+    {
+        pool->overloaded = false;
+        pool->minDelay = SteadyClock::duration::max();
+        pool->intervalEnd = now + pool->codelInterval;
+    }
+
+    /*
+     * 无锁队列模式的工作线程，队列为空时在MpmcQueue::pop中休眠，线程池关闭并且队列取空后退出
+     * 开启CoDel时只在拿到锁的时候采样排队时间，避免工作线程在无锁队列之外又竞争同一把锁
+     */
+    static void lockfreeWorker_(std::shared_ptr<Pool> pool)
+    {
+        Job job;
+        while (pool->ring->pop(job))
+        {
+            if (pool->codelTarget.count() > 0)
+            {
+                std::unique_lock<std::mutex> locker(pool->mtx, std::try_to_lock);
+                if (locker.owns_lock())
+                {
+                    codel_(pool.get(), job.enqueued);
+                }
+            }
+            job.run();
+        }
+    }
+
+    /*
+     * 工作窃取模式下从其他线程的双端队列顶部窃取任务，从随机位置开始轮询一遍
+     */
+    static bool steal_(Pool *pool, size_t self, std::mt19937 &rng, Job &job)
+    {
+        size_t n = pool->deques.size();
+        size_t start = rng() % n;
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t victim = (start + i) % n;
+            if (victim != self && pool->deques[victim]->steal(job))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * 工作窃取模式下其他线程的双端队列中是否还有任务，加锁后调用
+     * note: 批量转移只在加锁时进行，所以加锁后看到的队列长度至少包含之前所有的转移
+     */
+    static bool hasStealable_(Pool *pool, size_t self)
+    {
+        for (size_t i = 0; i < pool->deques.size(); i++)
+        {
+            if (i != self && pool->deques[i]->size() > 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * 工作窃取模式的工作线程
+     * 1. 优先从自己的双端队列底部取任务，不需要加锁
+     * 2. 自己的队列为空时加锁从全局队列批量取任务，执行第一个，其余放入自己的双端队列供其他线程窃取
+     * 3. 全局队列也为空时从其他线程的双端队列顶部窃取
+     * 4. 都没有任务时阻塞在条件变量上，等待addTask或批量转移任务的线程唤醒
+     */
+    static void stealingWorker_(std::shared_ptr<Pool> pool, size_t self)
+    {
+        WsDeque<Job> &deque = *pool->deques[self];
+        std::mt19937 rng(self);
+        Job job;
+        while (true)
+        {
+            if (deque.pop(job) || steal_(pool.get(), self, rng, job))
+            {
+                job.run();
+                continue;
+            }
+            std::unique_lock<std::mutex> locker(pool->mtx);
+            if (!pool->tasks.empty())
+            {
+                Job first = popTask_(pool.get());
+                // 批量转移到自己的双端队列，减少对全局锁的竞争
+                size_t moved = 0;
+                while (moved + 1 < BATCH_SIZE && !pool->tasks.empty() && deque.push(pool->tasks.front()))
+                {
+                    popTask_(pool.get());
+                    moved++;
+                }
+                // 有空闲线程时唤醒一个来窃取转移过来的任务，还没有计入idleCount的线程在等待前会重新检查双端队列
+                bool wake = moved > 0 && pool->idleCount > 0;
+                locker.unlock();
+                if (wake)
+                {
+                    pool->cond.notify_one();
+                }
+                first.run();
+                continue;
+            }
+            if (pool->isClosed)
+            {
+                break;
+            }
+            // note: 不加锁的pop/steal失败之后、拿到锁之前，其他线程可能已经在锁内转移了一批任务，
+            // 当时本线程还没有计入idleCount，不会被唤醒，所以等待前在锁内重新检查一遍
+            pool->idleCount++;
+            if (!hasStealable_(pool.get(), self))
+            {
+                pool->cond.wait(locker);
+            }
+            pool->idleCount--;
+        }
+    }
+
+    // 因为线程是在detach模式下运行的，所以这里使用动态申请的堆内存空间，使用shareptr管理
+    std::vector<std::shared_ptr<Pool>> pools_; // 亲和模式下每个工作线程一个，其余模式只有一个
 };
 
 #endif // THREAD_POOL_H
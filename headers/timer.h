@@ -0,0 +1,46 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 14:02:18
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 14:02:18
+ */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <chrono>
+
+#include "task.h"
+
+typedef Task TimeoutCallBack;                     // 超时回调，定长任务对象，不需要堆内存分配
+typedef std::chrono::high_resolution_clock Clock; // 获取时间的类
+typedef std::chrono::milliseconds MS;             // 毫秒
+typedef Clock::time_point TimeStamp;              // 时间戳
+
+/*
+ * 定时器接口，以文件描述符id为键管理连接的超时
+ * 实现：HeapTimer（小根堆，O(logn)）/TimeWheel（分层时间轮，O(1)）
+ */
+class Timer
+{
+public:
+    virtual ~Timer() {}
+    // 调整文件描述符id关联的定时器的过期时间为：当前时间+timeout
+    virtual void adjust(int id, int timeout) = 0;
+    // 将指定文件描述符id添加一个定时器，超时时间为timeout，回调函数为cb
+    virtual void add(int id, int timeout, const TimeoutCallBack &cb) = 0;
+    // 删除指定id结点，并触发回调函数
+    virtual void doWork(int id) = 0;
+    // 删除指定id结点，不触发回调函数，没有该结点时忽略
+    virtual void cancel(int id) = 0;
+    // 清空所有定时器
+    virtual void clear() = 0;
+    // 删除所有超时节点，并触发它们的回调函数
+    virtual void tick() = 0;
+    // 删除所有超时节点，返回最近一个超时节点的超时时间，没有定时器时返回-1
+    virtual int getNextTick() = 0;
+};
+
+#endif // TIMER_H
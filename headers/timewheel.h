@@ -0,0 +1,92 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 14:05:41
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 14:05:41
+ */
+#ifndef TIME_WHEEL_H
+#define TIME_WHEEL_H
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <assert.h>
+
+#include "log.h"
+#include "timer.h"
+
+/*
+ * 分层时间轮定时器，精度1ms
+ * 第0层256个槽，每槽1ms；第1~3层各64个槽，每槽分别为256ms、16s、17min，总范围约18.6小时
+ * 每个槽是一个双向链表，节点以fd为下标存放在数组中，添加、调整、删除都是O(1)的链表操作，没有哈希也没有堆调整
+ * 时间推进到第0层转满一圈时，把上一层对应槽中的节点重新插入到下层（级联）
+ * 每层用位图记录非空槽，推进时可以跳过空槽，计算最近的超时时间也不需要遍历
+ */
+class TimeWheel : public Timer
+{
+public:
+    // 构造函数，以当前时间作为第0个tick
+    TimeWheel();
+    // 析构函数，清空所有定时器
+    ~TimeWheel();
+    // 调整文件描述符id关联的定时器的过期时间为：当前时间+timeout
+    void adjust(int id, int timeout) override;
+    // 将指定文件描述符id添加一个定时器，超时时间为timeout，回调函数为cb
+    void add(int id, int timeout, const TimeoutCallBack &cb) override;
+    // 删除指定id结点，并触发回调函数
+    void doWork(int id) override;
+    // 删除指定id结点，不触发回调函数
+    void cancel(int id) override;
+    // 清空所有定时器
+    void clear() override;
+    // 推进时间轮，删除所有超时节点，并触发它们的回调函数
+    void tick() override;
+    // 删除所有超时节点，返回最近一个超时节点的超时时间，没有定时器时返回-1
+    int getNextTick() override;
+
+private:
+    // 以fd为下标的定时器节点
+    struct WheelNode
+    {
+        uint64_t expires;   // 超时时间，单位为tick
+        int prev;           // 链表中的前一个节点，-1表示链表头
+        int next;           // 链表中的后一个节点，-1表示链表尾
+        int slot;           // 所在的槽（全局编号），-1表示不在时间轮中
+        TimeoutCallBack cb; // 回调函数
+    };
+
+    static const int ROOT_BITS = 8;                               // 第0层槽数的位数
+    static const int LEVEL_BITS = 6;                              // 第1~3层槽数的位数
+    static const int LEVELS = 4;                                  // 层数
+    static const int ROOT_SIZE = 1 << ROOT_BITS;                  // 第0层槽数
+    static const int LEVEL_SIZE = 1 << LEVEL_BITS;                // 第1~3层槽数
+    static const int SLOT_NUM = ROOT_SIZE + (LEVELS - 1) * LEVEL_SIZE; // 槽的总数
+    static const uint64_t MAX_TICKS = 1ull << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS); // 时间轮能表示的最大超时
+
+    // 当前时间对应的tick
+    uint64_t now_() const;
+    // 返回fd对应的节点，数组不够大时扩容
+    WheelNode &node_(int id);
+    // 根据超时时间把节点挂到对应的槽上
+    void link_(int id);
+    // 把节点从所在槽上摘下
+    void unlink_(int id);
+    // 把第level层第index个槽中的节点重新插入到下层
+    void cascade_(int level, int index);
+    // 第0层中从from开始的第一个非空槽，没有时返回ROOT_SIZE
+    int findSlot_(int from) const;
+    // 第level层第index个槽的全局编号
+    static int slotOf_(int level, int index);
+
+    TimeStamp start_;                    // 第0个tick对应的时间
+    uint64_t current_;                   // 时间轮当前指向的tick，小于current_的tick都已经处理过
+    size_t count_;                       // 时间轮中的节点数
+    std::vector<WheelNode> nodes_;       // 以fd为下标的节点数组
+    std::vector<int> slots_;             // 每个槽的链表头，-1表示空槽
+    uint64_t bitmap_[SLOT_NUM / 64];     // 非空槽位图
+};
+
+#endif // TIME_WHEEL_H
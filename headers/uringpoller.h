@@ -0,0 +1,115 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 11:03:47
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 11:03:47
+ */
+#ifndef URING_POLLER_H
+#define URING_POLLER_H
+
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/*
+ * 基于io_uring的事件后端，作为Epoller的可选实现
+ * 注册/修改/删除事件不再是epoll_ctl系统调用，而是向提交队列（SQ）写入POLL_ADD/POLL_REMOVE请求：
+ * 1. 开启SQPOLL时由内核线程轮询提交队列，重新注册EPOLLONESHOT事件不需要任何系统调用
+ * 2. 未开启SQPOLL时，事件循环线程自己产生的请求在下一次wait时与等待合并为一次io_uring_enter
+ * 没有EPOLLONESHOT的描述符（监听、管道、eventfd）由后端自动重新注册，ET描述符使用multishot poll
+ * 完成事件（CQE）被转换为epoll_event，Epoller对外接口保持不变
+ */
+class UringPoller
+{
+public:
+    // 构造函数，创建io_uring实例并映射提交/完成队列，sqpoll为true时尝试开启SQPOLL
+    explicit UringPoller(unsigned entries = 4096, bool sqpoll = false);
+    // 析构函数，解除映射并关闭io_uring实例
+    ~UringPoller();
+    // io_uring是否创建成功（内核不支持时由Epoller回退到epoll）
+    bool isOpen() const;
+    // 是否开启了SQPOLL
+    bool isSqpoll() const;
+    // 注册事件
+    bool addFd(int fd, uint32_t events);
+    // 重新注册事件
+    bool modFd(int fd, uint32_t events);
+    // 删除事件
+    bool delFd(int fd);
+    // 等待事件，将完成事件转换为epoll_event写入events
+    int wait(struct epoll_event *events, int maxEvents, int timeoutMS);
+
+private:
+    // 每个描述符的注册信息
+    struct FdState
+    {
+        uint32_t gen;    // 注册代数，删除后自增，用来丢弃过期的完成事件
+        uint32_t events; // 注册的事件
+        bool armed;      // 是否有进行中的poll请求
+    };
+
+    // 创建io_uring实例并映射队列
+    bool setup_(unsigned entries, bool sqpoll);
+    // 获取一个空闲的SQE，调用者需持有mtx_
+    struct io_uring_sqe *getSqe_();
+    // 发布SQE，调用者需持有mtx_
+    void pushSqe_();
+    // 写入一个POLL_ADD请求，调用者需持有mtx_
+    bool pollAdd_(int fd);
+    // 写入一个POLL_REMOVE请求，调用者需持有mtx_
+    void pollRemove_(int fd);
+    // 确保已发布的SQE被内核看到，调用者需持有mtx_
+    void submit_();
+    // 返回fd对应的注册信息，调用者需持有mtx_
+    FdState &state_(int fd);
+    // 系统调用封装
+    int enter_(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize);
+
+    static const uint64_t REMOVE_TAG = ~0ull; // POLL_REMOVE请求自身完成事件的user_data
+
+    int ringFd_;  // io_uring实例的文件描述符
+    bool sqpoll_; // 是否开启SQPOLL（内核线程轮询提交队列）
+
+    // 提交队列
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqMask_;
+    unsigned *sqEntries_;
+    unsigned *sqFlags_;
+    unsigned *sqArray_;
+    struct io_uring_sqe *sqes_;
+    unsigned sqLocalTail_; // 本地写下标，发布后同步到sqTail_
+    // 完成队列
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned *cqMask_;
+    struct io_uring_cqe *cqes_;
+    // 映射的内存区域
+    void *sqPtr_;
+    void *cqPtr_;
+    size_t sqSize_;
+    size_t cqSize_;
+    size_t sqesSize_;
+
+    // note: 工作线程会调用modFd/delFd，提交队列只能有一个生产者，所以需要互斥量
+    std::mutex mtx_;
+    unsigned toSubmit_;              // 未开启SQPOLL时，已写入但尚未提交的SQE数量
+    std::atomic<bool> waiting_;      // 事件循环线程是否阻塞在wait中
+    std::vector<FdState> fdStates_;  // 以fd为下标的注册信息
+};
+
+#endif // URING_POLLER_H
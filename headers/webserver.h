@@ -10,7 +10,11 @@
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
-#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <fcntl.h> // fcntl()
 #include <errno.h>
 #include <unistd.h> // close()
@@ -18,15 +22,20 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h> // eventfd()
+#include <sys/stat.h>    // mkdir()
 
 #include "log.h"
 #include "epoller.h"
 #include "httpconn.h"
 #include "heaptimer.h"
+#include "timewheel.h"
 #include "threadpool.h"
 #include "sqlconnpoll.h"
 #include "sqlconnRAII.h"
 #include "sigutils.h"
+#include "spscqueue.h"
+#include "slab.h"
 
 class WebServer
 {
@@ -34,71 +43,149 @@ public:
     WebServer(int port, int trigMode, int timeoutMS, bool optLinger,
               int sqlPort, const char *sqlUser, const char *sqlPwd,
               const char *dbName, int connPoolNum, int threadNum,
-              bool openLog, int logLevel, int logQueSize, int actor, bool is_daemon);
+              bool openLog, int logLevel, int logQueSize, int actor, bool is_daemon,
+              int reactorMode, int reactorNum, int balance, int ioBackend,
+              int backlog, int acceptBatch, int timerType, bool lazyTimer,
+              int poolMode, int maxTasks, int rejectPolicy,
+              int codelTarget, int codelInterval, int dbThreadNum, bool pinCpu,
+              int maxThreadNum);
 
     ~WebServer();
     // 运行server
     void start();
 
 private:
+    /*
+     * 事件循环（one loop per thread）
+     * 每个Reactor独占一个epoller、一个定时器以及分配给它的一部分连接，只在自己的线程中处理事件
+     * 连接对象统一放在以fd为下标的users_中，fd在进程内唯一，所以各Reactor的连接互不重叠
+     */
+    // 主Reactor投递给子Reactor的新连接
+    struct Handoff
+    {
+        int fd;           // 连接描述符
+        sockaddr_in addr; // 客户端地址
+    };
+
+    struct Reactor
+    {
+        int id;                                  // Reactor编号，0号Reactor运行在主线程
+        int listenFd;                            // 监听描述符，-1表示该Reactor不负责accept
+        int wakeupFd;                            // eventfd，用于唤醒阻塞在epoll_wait上的Reactor
+        std::unique_ptr<Timer> timer;            // 定时器，小根堆或分层时间轮
+        TimeStamp now;                           // 每轮事件循环缓存一次的当前时间，惰性定时器模式使用
+        std::unique_ptr<Epoller> epoller;        // 监听实例epoller变量
+        std::thread thread;                      // 运行事件循环的线程（0号Reactor为主线程，不使用）
+        SpscQueue<Handoff> handoffs;             // 主Reactor投递过来的新连接，主从Reactor模式使用
+        std::atomic<int> connCount;              // 该Reactor当前负责的连接数，用于最少连接分配
+        std::mutex closeMtx;                     // 保护toClose
+        std::vector<HttpConn *> toClose;         // 工作线程请求关闭的连接，由本Reactor线程关闭
+        bool acceptPending;                      // 上一次accept用完了批量上限，监听队列中可能还有连接
+        uint64_t acceptCount;                    // accept成功的连接数（只在本Reactor线程修改）
+        uint64_t overflowCount;                  // 因连接数已满或投递队列已满而拒绝的连接数
+        uint64_t batchFullCount;                 // accept用完批量上限的次数
+    };
+
     // 设置文件描述符非阻塞
     static int setFdNonblock(int fd);
+    // 读取系统的监听队列上限/proc/sys/net/core/somaxconn
+    static int getSomaxconn_();
     // 初始化监听socket
-    bool initSocket_();
+    bool initSocket_(Reactor *reactor);
     // 初始化传递信号的管道
     bool initPipe_();
+    // 初始化唤醒Reactor的eventfd
+    bool initWakeup_(Reactor *reactor);
     // 初始化触发组合模式
     void initEventMode_(int trigMode);
     // 添加客户端
-    void addClient_(int fd, sockaddr_in addr);
+    void addClient_(Reactor *reactor, int fd, sockaddr_in addr);
 
     // 获取新连接，初始化客户端数据
-    void dealListen_();
+    void dealListen_(Reactor *reactor);
+    // 主从Reactor模式下选择接收新连接的子Reactor
+    Reactor *selectSubReactor_();
     // 处理信号事件
     void dealSignal_();
+    // 处理唤醒事件，接收主Reactor投递的新连接
+    void dealWakeup_(Reactor *reactor);
+    // 唤醒指定Reactor
+    void wakeup_(Reactor *reactor);
     // 调用ExtentTime_，并将写任务加入线程池的工作队列
-    void dealWrite_(HttpConn *client);
+    void dealWrite_(Reactor *reactor, HttpConn *client);
     // 调用ExtentTime_，并将读任务加入线程池的工作队列
-    void dealRead_(HttpConn *client);
+    void dealRead_(Reactor *reactor, HttpConn *client);
     // 发送错误信息给客户端并关闭连接
     void sendError_(int fd, const char *info);
+    // 线程池任务被拒绝或丢弃时，向客户端发送预先构造的503响应并关闭连接
+    void rejectConn_(Reactor *reactor, HttpConn *client);
     // 延长client的定时器的超时时长
-    void extentTime_(HttpConn *client);
-    // 关闭连接
-    void closeConn_(HttpConn *client);
+    void extentTime_(Reactor *reactor, HttpConn *client);
+    // 惰性定时器模式下的超时回调：检查最近一次活动时间，没有真正超时就重新调度，否则关闭连接
+    void dealTimeout_(Reactor *reactor, HttpConn *client);
+    // 关闭连接并删除定时器，只在Reactor线程中调用
+    void closeConn_(Reactor *reactor, HttpConn *client);
+    // 请求关闭连接（超时或出错），单所有者模式下交给连接的所有者关闭
+    void dealClose_(Reactor *reactor, HttpConn *client);
+    // 工作线程请求Reactor关闭连接
+    void postClose_(Reactor *reactor, HttpConn *client);
+    // 关闭工作线程请求关闭的连接
+    void dealPendingClose_(Reactor *reactor);
+    // 单所有者模式：记录连接上的就绪事件，获得所有权时把连接交给线程池
+    void dealEvent_(Reactor *reactor, HttpConn *client, uint32_t events);
 
     // 读取数据，并调用OnProcess处理请求
-    void onRead_(HttpConn *client);
+    void onRead_(Reactor *reactor, HttpConn *client);
     // 向客户端发送响应
-    void onWrite_(HttpConn *client);
+    void onWrite_(Reactor *reactor, HttpConn *client);
     // 调用process解析请求生成响应，然后修改监测事件：
     // 若生成了响应则改为监测写事件，否则说明没有解析请求，改为监测读事件
-    void onProcess_(HttpConn *client);
+    void onProcess_(Reactor *reactor, HttpConn *client);
+    // 单所有者模式：持有连接所有权，处理所有待处理事件（读、解析、写），直到没有新事件时释放所有权
+    void onEvent_(Reactor *reactor, HttpConn *client);
+    // 在数据库线程池中进行用户验证并生成响应，然后继续处理该连接
+    void onVerify_(Reactor *reactor, HttpConn *client);
+
+    // 运行reactor的事件循环，直到服务器关闭
+    void loop_(Reactor *reactor);
 
-    static const int MAX_FD = 65536; // 最大文件描述符数量
+    static const int MAX_FD = 65536;       // 最大文件描述符数量
+    static const int MAX_REACTOR = 64;     // 最大Reactor数量（包括主Reactor），dealListen_用64位位图记录要唤醒的子Reactor
+    static const char BUSY_RESPONSE[];     // 线程池过载时返回的503响应
 
     int port_;      // 监听的端口
     int timeoutMS_; // 超时时间，毫秒MS
-    int listenFd_;  // 监听的文件描述符
+    // note: 惰性定时器模式下读写事件只把缓存的当前时间写入HttpConn，不调整定时器，
+    // 定时器按最初的截止时间触发，触发时再根据最近一次活动时间判断是否真正超时
+    bool lazyTimer_; // 是否使用惰性定时器
     // note: SO_LINGER将决定系统如何处理残存在套接字发送队列中的数据
     // 处理方式无非两种：丢弃或者将数据继续发送至对端
-    bool openLinger_;   // 是否优雅关闭
-    bool isClose_;      // 是否关闭服务器，指示InitSocket操作是否成功
-    char *srcDir_;      // 资源文件目录
-    char *uploadDir_;   // 上传文件目录
-    int actor_;         // 事件处理模式：Reactor(0)/Proactor(1)
-    bool is_daemon_;    // 是否以守护进程方式启动
-    int pipefd_[2];     // 传递信号的管道
-    SigUtils sigutils_; // 信号处理对象
+    bool openLinger_;            // 是否优雅关闭
+    std::atomic<bool> isClose_;  // 是否关闭服务器，指示InitSocket操作是否成功，各Reactor线程共享
+    char *srcDir_;               // 资源文件目录
+    char *uploadDir_;            // 上传文件目录
+    int actor_;                  // 事件处理模式：Reactor(0)/Proactor(1)
+    bool is_daemon_;             // 是否以守护进程方式启动
+    int reactorMode_;            // 事件循环模式：单Reactor(0)/多Reactor+SO_REUSEPORT(1)/主从Reactor(2)
+    int balance_;                // 主从Reactor模式下新连接分配策略：轮询(0)/最少连接(1)
+    int backlog_;                // listen的监听队列长度
+    int acceptBatch_;            // 每次监听事件最多accept的连接数，0表示不限制
+    size_t nextReactor_;         // 轮询分配时下一个子Reactor的下标
+    int pipefd_[2];              // 传递信号的管道
+    SigUtils sigutils_;          // 信号处理对象
 
     uint32_t listenEvent_; // 监听描述符上的epoll事件
     uint32_t connEvent_;   // 连接描述符上的epoll事件
+    // note: 单所有者模式（Reactor+连接ET）下连接只注册一次EPOLLIN|EPOLLOUT|EPOLLET，不使用EPOLLONESHOT，
+    // 由HttpConn中的所有权标志保证同一时刻只有一个线程处理该连接，处理过程中不需要epoll_ctl重新注册
+    bool singleOwner_; // 是否使用单所有者模式
 
-    std::unique_ptr<HeapTimer> timer_;       // 基于小根堆的定时器
-    std::unique_ptr<ThreadPool> threadPool_; // 线程池
-    std::unique_ptr<Epoller> epoller_;       // 监听实例epoller变量
-    // note: 使用hash实现的文件描述符，这样可以用一个实例化一个，不用一开始就初始化很多个
-    std::unordered_map<int, HttpConn> users_; // 客户端连接集合，key为文件描述符fd
+    std::unique_ptr<ThreadPool> threadPool_;        // 线程池
+    // note: 登录、注册请求会同步访问MySQL，放在单独的线程池中，数据库变慢时不会占满处理静态文件请求的工作线程
+    std::unique_ptr<ThreadPool> dbPool_;            // 数据库线程池，为空表示在工作线程中直接访问数据库
+    std::vector<std::unique_ptr<Reactor>> reactors_; // 事件循环集合，0号为主Reactor
+    // note: 以fd为下标的连接池，按块分配且地址固定，事件分发时直接数组访问，不需要哈希，预热后没有内存分配
+    Slab<HttpConn> users_; // 客户端连接集合，下标为文件描述符fd
 };
 
 #endif // WEB_SERVER_H
@@ -0,0 +1,201 @@
+/*
+ * @Copyright: Copyright (c) 2022 WangXingyu All Rights Reserved.
+ * @Description:
+ * @Version:
+ * @Author: WangXingyu
+ * @Date: 2026-10-16 15:10:27
+ * @LastEditors: WangXingyu
+ * @LastEditTime: 2026-10-16 15:10:27
+ */
+#ifndef WS_DEQUE_H
+#define WS_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <type_traits>
+
+/*
+ * Chase-Lev工作窃取双端队列（定长）
+ * 所有者线程在底部push/pop，其他线程（窃取者）在顶部steal，只有队列中剩最后一个元素时才需要CAS
+ * 元素要求可平凡复制，每个槽按8字节分成若干个原子字存储，窃取者读到被覆盖的槽时CAS会失败并丢弃，不存在数据竞争
+ * 容量为2的幂，队列满时push返回false，由调用者把任务留在全局队列中
+ */
+template <class T>
+class WsDeque
+{
+    static_assert(std::is_trivially_copyable<T>::value, "WsDeque element must be trivially copyable");
+
+public:
+    // 构造函数，容量向上取整为2的幂
+    explicit WsDeque(size_t capacity = 256);
+    // 默认析构函数
+    ~WsDeque() = default;
+    // 在底部加入一个元素，队列满时返回false（仅所有者线程调用）
+    bool push(const T &item);
+    // 从底部取出一个元素，队列空时返回false（仅所有者线程调用）
+    bool pop(T &item);
+    // 从顶部窃取一个元素，队列空或与其他线程竞争失败时返回false（任意线程调用）
+    bool steal(T &item);
+    // 队列中元素个数（近似值）
+    size_t size() const;
+    // 队列容量
+    size_t capacity() const;
+
+private:
+    static const size_t WORDS = (sizeof(T) + 7) / 8; // 每个槽的原子字个数
+
+    // 槽
+    struct Slot
+    {
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    // 写入槽
+    void store_(int64_t index, const T &item);
+    // 读出槽
+    void load_(int64_t index, T &item) const;
+
+    std::unique_ptr<Slot[]> slots_; // 环形缓冲区
+    int64_t mask_;                  // 下标掩码，容量-1
+    // note: 顶部被窃取者修改，底部只被所有者修改，中间填充一个缓存行避免伪共享
+    std::atomic<int64_t> top_;    // 顶部下标，窃取者从这里取
+    char pad_[64];                // 缓存行填充
+    std::atomic<int64_t> bottom_; // 底部下标，所有者从这里存取
+};
+
+/*
+ * 构造函数，容量向上取整为2的幂
+ */
+template <class T>
+WsDeque<T>::WsDeque(size_t capacity) : top_(0), bottom_(0)
+{
+    assert(capacity > 0);
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    slots_.reset(new Slot[size]);
+    mask_ = size - 1;
+}
+
+/*
+ * 写入槽，按原子字逐个写入
+ */
+template <class T>
+void WsDeque<T>::store_(int64_t index, const T &item)
+{
+    uint64_t words[WORDS] = {0};
+    memcpy(words, &item, sizeof(T));
+    Slot &slot = slots_[index & mask_];
+    for (size_t i = 0; i < WORDS; i++)
+    {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+}
+
+/*
+ * 读出槽，按原子字逐个读出
+ */
+template <class T>
+void WsDeque<T>::load_(int64_t index, T &item) const
+{
+    uint64_t words[WORDS];
+    const Slot &slot = slots_[index & mask_];
+    for (size_t i = 0; i < WORDS; i++)
+    {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    memcpy(&item, words, sizeof(T));
+}
+
+/*
+ * 在底部加入一个元素，队列满时返回false
+ */
+template <class T>
+bool WsDeque<T>::push(const T &item)
+{
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_)
+    {
+        return false;
+    }
+    store_(b, item);
+    // release保证窃取者看到新的bottom_时元素已经写入
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+/*
+ * 从底部取出一个元素，队列空时返回false
+ * 先减小bottom_再读top_，只剩一个元素时与窃取者通过CAS竞争
+ */
+template <class T>
+bool WsDeque<T>::pop(T &item)
+{
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    // 队列为空，恢复bottom_
+    if (t > b)
+    {
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    load_(b, item);
+    // 还有不止一个元素，不会与窃取者冲突
+    if (t < b)
+    {
+        return true;
+    }
+    // 最后一个元素，与窃取者竞争
+    bool success = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return success;
+}
+
+/*
+ * 从顶部窃取一个元素，队列空或竞争失败时返回false
+ */
+template <class T>
+bool WsDeque<T>::steal(T &item)
+{
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return false;
+    }
+    // 先读出元素再CAS，CAS失败说明该槽已经被别人取走，读到的值丢弃
+    load_(t, item);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+/*
+ * 队列中元素个数（近似值）
+ */
+template <class T>
+size_t WsDeque<T>::size() const
+{
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+}
+
+/*
+ * 队列容量
+ */
+template <class T>
+size_t WsDeque<T>::capacity() const
+{
+    return mask_ + 1;
+}
+
+#endif // WS_DEQUE_H
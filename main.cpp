@@ -29,7 +29,12 @@ int main(int argc, char *argv[])
         config.port, config.trigMode, config.timeoutMS, config.OptLinger,                         // 端口 ET模式 timeoutMs 优雅退出
         config.sqlPort, config.sqlUser, config.sqlPwd, config.dbName,                             // Mysql配置
         config.connPoolNum, config.threadNum, config.openLog, config.logLevel, config.logQueSize, // 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量
-        config.actor, config.is_daemon                                                            // 事件模式 守护进程
+        config.actor, config.is_daemon,                                                           // 事件模式 守护进程
+        config.reactorMode, config.reactorNum, config.balance, config.ioBackend,                  // 事件循环模式 事件循环数量 连接分配策略 事件后端
+        config.backlog, config.acceptBatch, config.timerType, config.lazyTimer,                   // 监听队列长度 每次accept的最大连接数 定时器 惰性定时器
+        config.poolMode, config.maxTasks, config.rejectPolicy,                                    // 线程池调度模式 任务队列最大长度 拒绝策略
+        config.codelTarget, config.codelInterval, config.dbThreadNum, config.pinCpu,              // CoDel目标排队时间 CoDel观察区间 数据库线程池数量 绑定CPU
+        config.maxThreadNum                                                                       // 线程池数量上限
     );
     // WebServer启动
     server.start();